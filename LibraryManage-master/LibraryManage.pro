@@ -1,50 +1,32 @@
-QT       += core gui
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-CONFIG += c++11
-
-# You can make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-SOURCES += \
-    bookinfodialog.cpp \
-    logindialog.cpp \
-    main.cpp \
-    librarymain.cpp \
-    passworddialog.cpp \
-    selectdialog.cpp \
-    userinfodialog.cpp
-
-HEADERS += \
-    bookinfodialog.h \
-    librarydata.h \
-    librarymain.h \
-    logindialog.h \
-    passworddialog.h \
-    selectdialog.h \
-    userinfodialog.h
-
-FORMS += \
-    bookinfodialog.ui \
-    librarymain.ui \
-    logindialog.ui \
-    passworddialog.ui \
-    selectdialog.ui \
-    userinfodialog.ui
-
-TRANSLATIONS += \
-    LibraryManage_zh_CN.ts
-CONFIG += lrelease
-CONFIG += embed_translations
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
-
-DISTFILES += \
-    book.ico
-
-RC_ICONS = book.ico
+TEMPLATE = subdirs
+
+# core 为数据引擎（静态库 librarycore），不依赖 Qt，其余项目都链接它
+SUBDIRS += \
+    core \
+    gui \
+    server \
+    cli \
+    csvbench \
+    concurrencybench \
+    librarybench \
+    datagen
+
+gui.depends = core
+server.depends = core
+cli.depends = core
+
+csvbench.file = benchmark/csvbench.pro
+csvbench.makefile = Makefile.csvbench
+csvbench.depends = core
+
+concurrencybench.file = benchmark/concurrencybench.pro
+concurrencybench.makefile = Makefile.concurrencybench
+concurrencybench.depends = core
+
+librarybench.file = benchmark/librarybench.pro
+librarybench.makefile = Makefile.librarybench
+librarybench.depends = core
+
+datagen.file = benchmark/datagen.pro
+datagen.makefile = Makefile.datagen
+datagen.depends = core
@@ -0,0 +1,103 @@
+// 并发基准与压力检查：多个读线程同时查找、导出与统计，另有写线程不断借还
+// 用法：concurrencybench [图书数] [每轮秒数] [写线程数] [最多读线程数]
+// 读线程数从 1 开始逐轮翻倍，默认至硬件线程数，输出每轮读操作与借还的吞吐量；
+// 每轮结束后检查借阅记录的双向链接，出现不一致时返回 1
+#include "librarydata.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+std::atomic<bool> stopping(false);
+std::atomic<uint64_t> reads(0);
+std::atomic<uint64_t> writes(0);
+std::atomic<int> broken(0);		// 读线程看到的不一致借阅记录数
+
+// 读操作：分页模糊查找、按编号查找并读取借阅者、导出准备，偶尔统计全部借阅记录
+void reader(Library &library, int books, unsigned seed) {
+    std::mt19937 random(seed);
+    std::vector<Node<BookInfo>*> page;
+    uint64_t count = 0;
+    while (!stopping) {
+        switch (count % 256) {
+        case 0:
+            // 导出到其他文件只持有读锁；此处只准备内容，不写文件
+            library.prepareSave("concurrencybench_user.csv", "concurrencybench_book.csv");
+            break;
+        case 1:
+            library.checkLoans();
+            break;
+        default:
+            if (count % 2) {
+                page.clear();
+                library.fuzzyFindBook(std::to_string(random() % 1000), nullptr, true, 100, page);
+            } else {
+                // 持有读锁沿借阅记录走到用户一侧，借阅者的 books 不应为空
+                auto lock = library.readLock();
+                Node<BookInfo> *book = library.findBook((int)(random() % books) + 1);
+                for (auto *q = book->elem.readers.begin(); q != book->elem.readers.end(); q = q->next) {
+                    if (q->elem.user->elem.books.isEmpty()) broken++;
+                }
+            }
+        }
+        count++;
+    }
+    reads += count;
+}
+
+// 写操作：随机挑一对用户与图书，已借则还，未借且有剩余则借
+void writer(Library &library, int books, int users, unsigned seed) {
+    std::mt19937 random(seed);
+    uint64_t count = 0;
+    while (!stopping) {
+        int userID = (int)(random() % users) + 1;
+        int bookID = (int)(random() % books) + 1;
+        auto lock = library.writeLock();
+        Node<UserInfo> *user = library.findUser(userID);
+        Node<BookInfo> *book = library.findBook(bookID);
+        if (library.hasBorrowed(user, book)) {
+            library.returnBook(user, book);
+        } else if (book->elem.readers.size() < book->elem.quantity) {
+            library.borrowBook(user, book);
+        }
+        count++;
+    }
+    writes += count;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    int books = argc > 1 ? atoi(argv[1]) : 200000;
+    double seconds = argc > 2 ? atof(argv[2]) : 2;
+    int writers = argc > 3 ? atoi(argv[3]) : 2;
+    int users = std::max(1, books / 10);
+    int maxReaders = argc > 4 ? atoi(argv[4]) : (int)std::max(1u, std::thread::hardware_concurrency());
+
+    Library library;
+    for (int i = 1; i <= books; i++) library.add(BookInfo("图书" + std::to_string(i), i, 3));
+    for (int i = 1; i <= users; i++) library.add(UserInfo("用户" + std::to_string(i), "", i, 0));
+    printf("%d 本图书，%d 名用户，%d 个写线程，每轮 %.1f 秒\n", books, users, writers, seconds);
+
+    int failed = 0;
+    for (int readers = 1; readers <= maxReaders; readers *= 2) {
+        stopping = false;
+        reads = 0;
+        writes = 0;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < readers; i++) threads.emplace_back(reader, std::ref(library), books, 1 + i);
+        for (int i = 0; i < writers; i++) threads.emplace_back(writer, std::ref(library), books, users, 1001 + i);
+        auto start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stopping = true;
+        for (auto &thread : threads) thread.join();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        int problems = library.checkLoans() + broken.exchange(0);
+        printf("读线程 %3d  读 %12.0f 次/秒  借还 %10.0f 次/秒  借阅记录%s\n", readers,
+               reads / elapsed.count(), writes / elapsed.count(), problems ? "不一致" : "一致");
+        if (problems) failed = 1;
+    }
+    return failed;
+}
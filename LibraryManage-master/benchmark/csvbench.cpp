@@ -0,0 +1,210 @@
+// csv 读取吞吐量基准：在同一组数据文件上比较最初的逐行 getline 读取方式与当前的 Library::read
+// 用法：csvbench [book.csv user.csv] [重复次数]
+// 未指定文件时生成 100 万本图书、10 万名用户的测试数据 csvbench_book.csv、csvbench_user.csv，结束时删除；
+// 也可用 datagen 生成的文件。吞吐量按两个 csv 文件的总字节数计算，快照一项同样按 csv 字节数折算
+#include "librarydata.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+namespace {
+
+const char DIVIDE = ',';
+const char *const BOOK_FILE = "csvbench_book.csv";
+const char *const USER_FILE = "csvbench_user.csv";
+
+// 最初的读取方式：逐行 getline，逐字符拼接字段，用 atoi 解析，借阅编号先存入 List<int>
+// 原实现随后按编号逐个线性查找以建立借阅链接（O(n²)），大数据量下无法完成，这里只计解析部分，是其耗时的下限
+struct LegacyBook {
+    string name;
+    int identifier = 0;
+    int quantity = 0;
+    List<int> IDs;
+
+    LegacyBook() {}
+    LegacyBook(int n): identifier(n) {}	// List 的哨兵节点需要
+};
+
+struct LegacyUser {
+    string name;
+    string password;
+    int identifier = 0;
+    int type = 0;
+    List<int> IDs;
+
+    LegacyUser() {}
+    LegacyUser(int n): identifier(n) {}
+};
+
+size_t legacyBooks(const char *fileName, List<LegacyBook> &books) {
+    ifstream input(fileName);
+    while (!input.eof()) {
+        string line;
+        getline(input, line);
+        if (line.empty()) continue;
+        line += '\n';
+
+        string buff;
+        LegacyBook book;
+        int cnt = 0;
+        for (string::iterator i = line.begin(); i != line.end(); i++) {
+            if (*i == DIVIDE || *i == '\n') {
+                switch (cnt) {
+                case 0:
+                    book.name = buff;
+                    buff.clear(); break;
+                case 1:
+                    book.identifier = atoi(buff.data());
+                    buff.clear(); break;
+                case 2:
+                    book.quantity = atoi(buff.data());
+                    buff.clear(); break;
+                default:
+                    int id = atoi(buff.data());
+                    if (id) book.IDs.append(id);
+                    buff.clear(); break;
+                }
+                cnt++;
+            } else {
+                buff += *i;
+            }
+        }
+        books.append(book);
+    }
+    return books.size();
+}
+
+size_t legacyUsers(const char *fileName, List<LegacyUser> &users) {
+    ifstream input(fileName);
+    while (!input.eof()) {
+        string line;
+        getline(input, line);
+        if (line.empty()) continue;
+        line += '\n';
+
+        string buff;
+        LegacyUser user;
+        int cnt = 0;
+        for (string::iterator i = line.begin(); i != line.end(); i++) {
+            if (*i == DIVIDE || *i == '\n') {
+                switch (cnt) {
+                case 0:
+                    user.name = buff;
+                    buff.clear(); break;
+                case 1:
+                    user.password = buff;
+                    buff.clear(); break;
+                case 2:
+                    user.identifier = atoi(buff.data());
+                    buff.clear(); break;
+                case 3:
+                    user.type = atoi(buff.data());
+                    buff.clear(); break;
+                default:
+                    int id = atoi(buff.data());
+                    if (id) user.IDs.append(id);
+                    buff.clear(); break;
+                }
+                cnt++;
+            } else {
+                buff += *i;
+            }
+        }
+        users.append(user);
+    }
+    return users.size();
+}
+
+// 通过 Library 生成测试数据：每名用户借两本书，两个文件中的借阅编号互相对应
+void generate(const char *userFile, const char *bookFile, int bookCount) {
+    Library library(DIVIDE);
+    int userCount = bookCount / 10;
+    for (int i = 1; i <= bookCount; i++) {
+        library.add(BookInfo("图书" + std::to_string(i), i, i % 5 + 1));
+    }
+    for (int i = 1; i <= userCount; i++) {
+        auto *user = library.add(UserInfo("用户" + std::to_string(i), std::to_string(100000 + i), i, i == 1));
+        for (int j = 0; j < 2; j++) {
+            library.borrowBook(user, library.findBook((i * 20 + j * 10) % bookCount + 1));
+        }
+    }
+    library.write(userFile, bookFile);
+}
+
+void removeDerived(const char *bookFile) {
+    std::remove(snapshot::pathFor(bookFile).c_str());
+    std::remove(Journal::pathFor(bookFile).c_str());
+}
+
+// 重复 repeat 次取最快的一次；prepare 不计入耗时
+template<class Prepare, class Read>
+void run(const char *label, uint64_t bytes, int repeat, Prepare prepare, Read read) {
+    double best = 1e30;
+    size_t records = 0;
+    for (int i = 0; i < repeat; i++) {
+        prepare();
+        auto start = std::chrono::steady_clock::now();
+        records = read();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < best) best = elapsed.count();
+    }
+    printf("%-24s %10zu 条  %8.3f s  %8.1f MB/s\n", label, records, best, bytes / best / 1e6);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    bool generated = argc < 3;
+    const char *bookFile = generated ? BOOK_FILE : argv[1];
+    const char *userFile = generated ? USER_FILE : argv[2];
+    int repeat = argc == 2 ? atoi(argv[1]) : argc > 3 ? atoi(argv[3]) : 3;
+    if (repeat < 1) repeat = 1;
+    if (generated) generate(userFile, bookFile, 1000000);
+
+    snapshot::FileStamp bookStamp, userStamp;
+    if (!snapshot::stamp(bookFile, bookStamp) || !snapshot::stamp(userFile, userStamp)) {
+        cerr << "无法打开文件 " << bookFile << " 或 " << userFile << endl;
+        return 1;
+    }
+    uint64_t bytes = bookStamp.size + userStamp.size;
+    printf("%s + %s: %.1f MB\n", bookFile, userFile, bytes / 1e6);
+
+    // 各次读取的结果在计时之外释放
+    std::unique_ptr<List<LegacyBook>> legacyBookList;
+    std::unique_ptr<List<LegacyUser>> legacyUserList;
+    run("getline（最初，仅解析）", bytes, repeat, [&]() {
+        legacyBookList = std::make_unique<List<LegacyBook>>();
+        legacyUserList = std::make_unique<List<LegacyUser>>();
+    }, [&]() {
+        return legacyUsers(userFile, *legacyUserList) + legacyBooks(bookFile, *legacyBookList);
+    });
+    legacyBookList.reset();
+    legacyUserList.reset();
+
+    std::unique_ptr<Library> library;
+    run("Library.read(csv)", bytes, repeat, [&]() {
+        library.reset();
+        removeDerived(bookFile);
+        library = std::make_unique<Library>(DIVIDE);
+    }, [&]() {
+        library->read(userFile, bookFile);
+        return (size_t)(library->books.size() + library->users.size());
+    });
+    library->write(userFile, bookFile);	// 数据未变，只写出快照
+    run("Library.read(snapshot)", bytes, repeat, [&]() {
+        library.reset();
+        library = std::make_unique<Library>(DIVIDE);
+    }, [&]() {
+        library->read(userFile, bookFile);
+        return (size_t)(library->books.size() + library->users.size());
+    });
+    library.reset();
+
+    removeDerived(bookFile);
+    if (generated) {
+        std::remove(bookFile);
+        std::remove(userFile);
+    }
+    return 0;
+}
@@ -0,0 +1,339 @@
+// 测试数据生成：按给定规模生成格式与 bookDataReader/userDataReader 一致的 book.csv 与 user.csv
+// 用法：datagen [--books=图书数] [--users=用户数] [--loans=借阅数] [--zipf=指数] [--cjk=中文名比例]
+//              [--seed=种子] [--divide=分隔符] [--book=图书文件] [--user=用户文件]
+// 借阅的图书按 Zipf 分布选取（热门图书被借得多，馆藏也相应多），借阅者均匀选取；两个文件中的借阅编号互相对应。
+// 编号 1 的用户是管理员 admin（密码 admin），其余用户的密码为 6 位数字。种子相同时生成的文件相同
+#include "csvwriter.h"
+
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::string;
+
+namespace {
+
+// 按 Zipf 分布在 1…n 中取值，取 k 的概率正比于 1 / k^s（拒绝-逆变换采样，每次 O(1)，无需累积分布表）
+class ZipfSampler {
+public:
+    ZipfSampler(uint64_t n, double s): n(n), s(s) {
+        hIntegralX1 = hIntegral(1.5) - 1;
+        hIntegralN = hIntegral(n + 0.5);
+        threshold = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+    }
+
+    template<class Random>
+    uint64_t operator ()(Random &random) const {
+        for (;;) {
+            double u = hIntegralN + uniform(random) * (hIntegralX1 - hIntegralN);
+            double x = hIntegralInverse(u);
+            uint64_t k = (uint64_t)(x + 0.5);
+            if (k < 1) k = 1;
+            else if (k > n) k = n;
+            if (k - x <= threshold || u >= hIntegral(k + 0.5) - h((double)k)) return k;
+        }
+    }
+
+    // [0, 1) 内的均匀分布，不依赖标准库分布的实现，各平台结果一致
+    template<class Random>
+    static double uniform(Random &random) {
+        return (random() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+private:
+    uint64_t n;
+    double s;
+    double hIntegralX1, hIntegralN, threshold;
+
+    double h(double x) const {
+        return std::exp(-s * std::log(x));
+    }
+    // h 的原函数
+    double hIntegral(double x) const {
+        double logX = std::log(x);
+        return helper2((1 - s) * logX) * logX;
+    }
+
+    double hIntegralInverse(double x) const {
+        double t = x * (1 - s);
+        if (t < -1) t = -1;
+        return std::exp(helper1(t) * x);
+    }
+    // log(1 + x) / x，x 接近 0 时用级数
+    static double helper1(double x) {
+        if (std::fabs(x) > 1e-8) return std::log1p(x) / x;
+        return 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+    // (exp(x) - 1) / x
+    static double helper2(double x) {
+        if (std::fabs(x) > 1e-8) return std::expm1(x) / x;
+        return 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+    }
+};
+
+const char *const SURNAMES[] = {
+    "王", "李", "张", "刘", "陈", "杨", "黄", "赵", "吴", "周", "徐", "孙", "马", "朱", "胡", "郭", "何",
+    "高", "林", "罗", "郑", "梁", "谢", "宋", "唐", "许", "韩", "冯", "邓", "曹", "彭", "曾", "肖", "田",
+    "董", "袁", "潘", "于", "蒋", "蔡", "余", "杜", "叶", "程", "苏", "魏", "吕", "丁", "任", "沈"
+};
+const char *const GIVEN[] = {
+    "伟", "芳", "娜", "敏", "静", "丽", "强", "磊", "军", "洋", "勇", "艳", "杰", "娟", "涛", "明",
+    "超", "秀", "霞", "平", "刚", "桂", "英", "华", "玉", "萍", "红", "飞", "鹏", "辉", "建", "文",
+    "斌", "宇", "浩", "凯", "晨", "欣", "雪", "琳", "婷", "慧", "佳", "俊", "博", "思", "雨", "子",
+    "涵", "轩", "怡", "梓", "睿", "泽", "嘉", "悦", "晓", "天", "一", "宁"
+};
+const char *const FIRST_NAMES[] = {
+    "James", "Mary", "John", "Linda", "Robert", "Emma", "Michael", "Olivia", "David", "Sophia",
+    "William", "Ava", "Richard", "Mia", "Joseph", "Emily", "Thomas", "Grace", "Daniel", "Chloe",
+    "Henry", "Lucy", "Jack", "Alice", "Samuel", "Hannah", "Peter", "Ella", "Oliver", "Zoe"
+};
+const char *const LAST_NAMES[] = {
+    "Smith", "Johnson", "Brown", "Taylor", "Miller", "Wilson", "Moore", "Anderson", "Thomas", "Jackson",
+    "White", "Harris", "Martin", "Thompson", "Garcia", "Clark", "Lewis", "Walker", "Hall", "Young",
+    "King", "Wright", "Scott", "Green", "Baker", "Adams", "Nelson", "Carter", "Mitchell", "Turner"
+};
+const char *const CJK_TOPICS[] = {
+    "数据结构", "算法", "操作系统", "计算机网络", "编译原理", "线性代数", "概率论", "高等数学", "大学物理",
+    "有机化学", "分子生物学", "中国古代史", "世界近代史", "西方哲学", "宏观经济学", "微观经济学", "管理学",
+    "市场营销", "会计学", "法理学", "刑法学", "心理学", "社会学", "教育学", "现代汉语", "古代文学",
+    "外国文学", "艺术设计", "音乐理论", "建筑学", "城市规划", "天文学", "地质学", "生态学", "临床医学",
+    "药理学", "机械设计", "电路分析", "信号与系统", "人工智能"
+};
+const char *const CJK_FORMS[] = {
+    "导论", "原理", "教程", "基础", "简史", "概论", "实践", "手册", "精要", "十讲", "研究", "新编"
+};
+const char *const ASCII_TOPICS[] = {
+    "Algorithms", "Data Structures", "Operating Systems", "Computer Networks", "Compilers",
+    "Linear Algebra", "Probability", "Calculus", "Physics", "Organic Chemistry", "Molecular Biology",
+    "World History", "Philosophy", "Economics", "Management", "Marketing", "Accounting", "Law",
+    "Psychology", "Sociology", "Education", "Linguistics", "Literature", "Design", "Music Theory",
+    "Architecture", "Astronomy", "Geology", "Ecology", "Medicine"
+};
+const char *const ASCII_FORMS[] = {
+    "Introduction to ", "Principles of ", "A History of ", "Essentials of ", "Modern ", "Advanced "
+};
+
+template<class T, size_t N>
+constexpr uint64_t countOf(T (&)[N]) {
+    return N;
+}
+
+// 与 m 互素的乘数，把 [0, m) 打乱为一一对应的排列
+uint64_t coprimeStep(uint64_t m, uint64_t hint) {
+    if (m <= 1) return 1;
+    uint64_t step = hint % m;
+    if (step == 0) step = 1;
+    for (;;) {
+        uint64_t a = step, b = m;
+        while (b) {
+            uint64_t t = a % b;
+            a = b;
+            b = t;
+        }
+        if (a == 1) return step;
+        step = step + 1 < m ? step + 1 : 1;
+    }
+}
+
+// 由编号生成互不重复的用户名：中文名与英文名各自按编号一一对应，组合用尽后追加序号
+class NameMaker {
+public:
+    explicit NameMaker(uint64_t seed) {
+        cjkCount = countOf(SURNAMES) * countOf(GIVEN) * (countOf(GIVEN) + 1);
+        asciiCount = countOf(FIRST_NAMES) * 26 * countOf(LAST_NAMES);
+        cjkStep = coprimeStep(cjkCount, seed * 2654435761u + 97);
+        asciiStep = coprimeStep(asciiCount, seed * 40503u + 89);
+    }
+
+    void user(string &name, uint64_t index, bool cjk) const {
+        name.clear();
+        uint64_t count = cjk ? cjkCount : asciiCount;
+        uint64_t round = index / count;
+        uint64_t k = index % count * (cjk ? cjkStep : asciiStep) % count;
+        if (cjk) {
+            name += SURNAMES[k % countOf(SURNAMES)];
+            k /= countOf(SURNAMES);
+            name += GIVEN[k % countOf(GIVEN)];
+            k /= countOf(GIVEN);
+            if (k < countOf(GIVEN)) name += GIVEN[k];	// 取 countOf(GIVEN) 时为单名
+        } else {
+            name += FIRST_NAMES[k % countOf(FIRST_NAMES)];
+            k /= countOf(FIRST_NAMES);
+            name += ' ';
+            name += (char)('A' + k % 26);
+            name += ' ';
+            name += LAST_NAMES[k / 26];
+        }
+        if (round) name += std::to_string(round);
+    }
+
+    // 书名允许重复，同一书名的多个版本以版次区分
+    template<class Random>
+    static void book(string &name, Random &random, bool cjk) {
+        uint64_t r = random();
+        unsigned edition = (unsigned)(r >> 40) % 4 + 1;
+        name.clear();
+        if (cjk) {
+            name += CJK_TOPICS[r % countOf(CJK_TOPICS)];
+            name += CJK_FORMS[(r >> 16) % countOf(CJK_FORMS)];
+            if (edition > 1) {
+                name += "（第";
+                name += std::to_string(edition);
+                name += "版）";
+            }
+        } else {
+            name += ASCII_FORMS[(r >> 16) % countOf(ASCII_FORMS)];
+            name += ASCII_TOPICS[r % countOf(ASCII_TOPICS)];
+            if (edition > 1) {
+                name += " (Edition ";
+                name += std::to_string(edition);
+                name += ')';
+            }
+        }
+    }
+
+private:
+    uint64_t cjkCount, asciiCount;
+    uint64_t cjkStep, asciiStep;
+};
+
+// 把借阅按 key（图书或用户编号，从 1 开始）分组：owner 中第 start[key - 1] 至 start[key] - 1 项属于 key
+void groupLoans(const std::vector<uint32_t> &keys, const std::vector<uint32_t> &values, uint32_t count,
+                std::vector<uint64_t> &start, std::vector<uint32_t> &owner) {
+    start.assign((size_t)count + 1, 0);
+    for (uint32_t key : keys) start[key]++;
+    for (uint32_t i = 1; i <= count; i++) start[i] += start[i - 1];
+    std::vector<uint64_t> next(start.begin(), start.end() - 1);
+    owner.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) owner[next[keys[i] - 1]++] = values[i];
+}
+
+bool option(const char *arg, const char *name, const char *&value) {
+    size_t length = strlen(name);
+    if (strncmp(arg, name, length) || arg[length] != '=') return false;
+    value = arg + length + 1;
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t books = 100000, users = 0, loans = 0, seed = 1;
+    bool usersGiven = false, loansGiven = false;
+    double zipf = 1.0, cjk = 0.7;
+    char divide = ',';
+    const char *bookFile = "book.csv";
+    const char *userFile = "user.csv";
+    for (int i = 1; i < argc; i++) {
+        const char *value;
+        if (option(argv[i], "--books", value)) books = strtoull(value, nullptr, 10);
+        else if (option(argv[i], "--users", value)) users = strtoull(value, nullptr, 10), usersGiven = true;
+        else if (option(argv[i], "--loans", value)) loans = strtoull(value, nullptr, 10), loansGiven = true;
+        else if (option(argv[i], "--zipf", value)) zipf = atof(value);
+        else if (option(argv[i], "--cjk", value)) cjk = atof(value);
+        else if (option(argv[i], "--seed", value)) seed = strtoull(value, nullptr, 10);
+        else if (option(argv[i], "--divide", value)) divide = value[0];
+        else if (option(argv[i], "--book", value)) bookFile = value;
+        else if (option(argv[i], "--user", value)) userFile = value;
+        else {
+            fprintf(stderr, "无法识别的参数 %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!usersGiven) users = books / 10 ? books / 10 : 1;
+    if (!loansGiven) loans = users * 2;
+    if (books < 1 || users < 1 || books > INT32_MAX || users > INT32_MAX || loans > UINT32_MAX) {
+        fprintf(stderr, "图书数与用户数应在 1 至 %d 之间，借阅数不超过 %u。\n", INT32_MAX, UINT32_MAX);
+        return 1;
+    }
+    if (zipf <= 0 || cjk < 0 || cjk > 1) {
+        fprintf(stderr, "Zipf 指数应大于 0，中文名比例应在 0 至 1 之间。\n");
+        return 1;
+    }
+    // 名称中会出现字母、数字、空格与括号，分隔符不能取这些字符
+    if (!divide || isalnum((unsigned char)divide) || strchr(" ()\"\r\n", divide)) {
+        fprintf(stderr, "分隔符不能是字母、数字、空格、括号、引号或换行。\n");
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::mt19937_64 random(seed);
+
+    // 借阅：图书按热度排名的 Zipf 分布选取，排名经打乱映射到编号，热门图书不集中在编号前部
+    ZipfSampler popularity(books, zipf);
+    uint64_t step = coprimeStep(books, random());
+    std::vector<uint32_t> loanBook(loans), loanUser(loans);
+    for (uint64_t i = 0; i < loans; i++) {
+        loanBook[i] = (uint32_t)((popularity(random) - 1) * step % books + 1);
+        loanUser[i] = (uint32_t)(random() % users + 1);
+    }
+    std::vector<uint64_t> readerStart, bookStart;
+    std::vector<uint32_t> readers, borrowed;
+    groupLoans(loanBook, loanUser, (uint32_t)books, readerStart, readers);
+    groupLoans(loanUser, loanBook, (uint32_t)users, bookStart, borrowed);
+    std::vector<uint32_t>().swap(loanBook);
+    std::vector<uint32_t>().swap(loanUser);
+
+    string name;
+    CsvWriter bookOut(bookFile, divide);
+    if (!bookOut.isOpen()) {
+        fprintf(stderr, "无法写入文件 %s\n", bookFile);
+        return 1;
+    }
+    for (uint64_t id = 1; id <= books; id++) {
+        uint64_t first = readerStart[id - 1], last = readerStart[id];
+        NameMaker::book(name, random, ZipfSampler::uniform(random) < cjk);
+        // 馆藏数不少于借出数，另有 0 至 2 本在架
+        int quantity = (int)(last - first + random() % 3);
+        bookOut.write(name);
+        bookOut.field((int)id);
+        bookOut.field(quantity ? quantity : 1);
+        for (uint64_t i = first; i < last; i++) bookOut.field((int)readers[i]);
+        bookOut.endLine();
+    }
+    if (!bookOut.commit()) {
+        fprintf(stderr, "无法写入文件 %s\n", bookFile);
+        return 1;
+    }
+
+    NameMaker names(seed);
+    char password[8];
+    CsvWriter userOut(userFile, divide);
+    if (!userOut.isOpen()) {
+        fprintf(stderr, "无法写入文件 %s\n", userFile);
+        return 1;
+    }
+    for (uint64_t id = 1; id <= users; id++) {
+        bool admin = id == 1;
+        if (admin) {
+            name = "admin";
+            strcpy(password, "admin");
+        } else {
+            names.user(name, id - 1, ZipfSampler::uniform(random) < cjk);
+            snprintf(password, sizeof(password), "%06u", (unsigned)(random() % 1000000));
+        }
+        userOut.write(name);
+        userOut.field(password);
+        userOut.field((int)id);
+        userOut.field(admin ? 1 : 0);
+        for (uint64_t i = bookStart[id - 1]; i < bookStart[id]; i++) userOut.field((int)borrowed[i]);
+        userOut.endLine();
+    }
+    if (!userOut.commit()) {
+        fprintf(stderr, "无法写入文件 %s\n", userFile);
+        return 1;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    fprintf(stderr, "已生成 %llu 本图书（%s）、%llu 名用户（%s）、%llu 条借阅，用时 %.2f 秒\n",
+            (unsigned long long)books, bookFile, (unsigned long long)users, userFile,
+            (unsigned long long)loans, elapsed.count());
+    return 0;
+}
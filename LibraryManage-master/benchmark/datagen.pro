@@ -0,0 +1,8 @@
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+include(../core/core.pri)
+
+SOURCES += \
+    datagen.cpp
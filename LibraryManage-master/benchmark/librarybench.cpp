@@ -0,0 +1,289 @@
+// 引擎基准：在不同规模（默认 1 万、10 万、100 万本图书，用户为其 1/10）下测量链表、按编号与名称查找、
+// 模糊查找、借还、写出与读取数据文件，以及两种混合借还负载
+// 用法：librarybench [每项至多秒数] [图书数…]
+// 结果以 JSON 输出到标准输出：每项的吞吐量（次/秒）、延迟分位数（纳秒）与平均每次操作的内存分配次数，
+// 重定向到文件后可与其他版本的结果对比；进度输出到标准错误。运行时在当前目录生成 librarybench_* 文件，结束时删除
+#include "librarydata.h"
+
+#include <chrono>
+#include <cstdio>
+#include <new>
+#include <random>
+
+namespace {
+
+std::atomic<uint64_t> allocations(0);	// 程序启动以来 operator new 的调用次数
+
+// 不内联，否则 GCC 会把内联后的 free 误报为与 operator new 不配对
+#ifdef __GNUC__
+__attribute__((noinline))
+#endif
+void release(void *p) {
+    free(p);
+}
+
+}
+
+// 替换全局的 operator new/delete 以统计分配次数，引擎内部的分配同样计入
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    release(p);
+}
+
+void operator delete[](void *p) noexcept {
+    release(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    operator delete(p);
+}
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// 一项操作的测量结果
+struct Result {
+    string op;
+    int records;
+    uint64_t ops;
+    int batch;				// 每个延迟样本包含的连续操作数
+    double seconds;
+    uint64_t allocations;
+    std::vector<double> samples;	// 各样本中平均每次操作的纳秒数
+};
+
+std::vector<Result> results;
+double budget = 1;		// 每项操作至多运行的秒数
+int records = 0;		// 当前规模的图书数
+volatile size_t sink;	// 防止结果未被使用的调用被优化掉
+
+// 依次执行 op(0) … op(count - 1)，每 batch 次计一个延迟样本；bounded 为 true 时超过 budget 秒即停止
+// prepare(i) 在每个样本前调用，不计入时间与分配次数；返回实际执行的次数
+template<class Prepare, class Op>
+uint64_t measure(const char *name, uint64_t count, int batch, bool bounded, Prepare prepare, Op op) {
+    Result result{name, records, 0, batch, 0, 0, {}};
+    result.samples.reserve((size_t)(count / batch + 1));
+    double spent = 0;
+    uint64_t allocated = 0;
+    while (result.ops < count && (!bounded || spent < budget)) {
+        uint64_t end = result.ops + batch < count ? result.ops + batch : count;
+        prepare(result.ops);
+        uint64_t before = allocations.load(std::memory_order_relaxed);
+        auto start = Clock::now();
+        for (uint64_t i = result.ops; i < end; i++) op(i);
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        allocated += allocations.load(std::memory_order_relaxed) - before;
+        spent += elapsed.count();
+        result.samples.push_back(elapsed.count() * 1e9 / (end - result.ops));
+        result.ops = end;
+    }
+    result.seconds = spent;
+    result.allocations = allocated;
+    fprintf(stderr, "  %-28s %10llu 次  %12.0f 次/秒\n", name, (unsigned long long)result.ops,
+            result.ops / (spent > 0 ? spent : 1e-9));
+    results.push_back(std::move(result));
+    return results.back().ops;
+}
+
+template<class Op>
+uint64_t measure(const char *name, uint64_t count, int batch, Op op) {
+    return measure(name, count, batch, true, [](uint64_t) {}, op);
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+void printJson() {
+    printf("{\n  \"benchmark\": \"librarybench\",\n  \"budgetSeconds\": %g,\n  \"results\": [\n", budget);
+    for (size_t i = 0; i < results.size(); i++) {
+        Result &r = results[i];
+        std::sort(r.samples.begin(), r.samples.end());
+        double ops = r.ops ? (double)r.ops : 1;
+        printf("    {\"op\": \"%s\", \"records\": %d, \"ops\": %llu, \"batch\": %d, \"seconds\": %.6f, "
+               "\"opsPerSec\": %.1f, \"latencyNs\": {\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, "
+               "\"p999\": %.1f, \"max\": %.1f}, \"allocsPerOp\": %.3f}%s\n",
+               r.op.c_str(), r.records, (unsigned long long)r.ops, r.batch, r.seconds,
+               r.seconds > 0 ? r.ops / r.seconds : 0.0, percentile(r.samples, 0.5), percentile(r.samples, 0.9),
+               percentile(r.samples, 0.99), percentile(r.samples, 0.999),
+               r.samples.empty() ? 0.0 : r.samples.back(), r.allocations / ops, i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+const char *const WORDS[] = {
+    "数据", "结构", "算法", "历史", "文学", "科学", "艺术", "经济", "哲学", "物理", "化学", "生物",
+    "地理", "音乐", "电影", "建筑", "法律", "医学", "教育", "心理", "语言", "数学", "天文", "军事",
+    "农业", "工程", "计算", "网络", "设计", "管理", "金融", "旅行"
+};
+const int WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+string bookName(int id) {
+    return string(WORDS[id % WORD_COUNT]) + WORDS[id / WORD_COUNT % WORD_COUNT] + std::to_string(id);
+}
+
+const char *const BOOK_FILE = "librarybench_book.csv";
+const char *const USER_FILE = "librarybench_user.csv";
+
+void removeFiles() {
+    std::remove(BOOK_FILE);
+    std::remove(USER_FILE);
+    std::remove(snapshot::pathFor(BOOK_FILE).c_str());
+    std::remove(Journal::pathFor(BOOK_FILE).c_str());
+}
+
+void benchList(int n, std::mt19937 &random) {
+    List<int> list;
+    measure("List.append", n, 16, false, [](uint64_t) {}, [&](uint64_t i) { list.append((int)i); });
+    std::vector<int> index(10000);
+    for (int &i : index) i = (int)(random() % n);
+    measure("List.getNode", index.size(), 1, [&](uint64_t i) { sink = (size_t)list.getNode(index[i]); });
+    measure("List.traverse", 1000, 1, [&](uint64_t) {
+        size_t sum = 0;
+        for (auto *p = list.begin(); p != list.end(); p = p->next) sum += p->elem;
+        sink = sum;
+    });
+    measure("List.del", n, 16, false, [](uint64_t) {}, [&](uint64_t) { list.del(list.begin()); });
+}
+
+// 混合负载：按比例随机执行按编号查找、分页模糊查找与借还（已借则还，未借且有剩余则借）
+void benchCirculation(const char *name, Library &library, int users, int findPercent, int searchPercent,
+                      std::mt19937 &random) {
+    const uint64_t count = 1000000;
+    std::vector<uint32_t> plan(count);
+    for (auto &step : plan) step = (uint32_t)random();
+    std::vector<Node<BookInfo>*> page;
+    measure(name, count, 1, [&](uint64_t i) {
+        uint32_t step = plan[i];
+        int roll = step % 100;
+        int bookID = (int)(step / 100 % records) + 1;
+        if (roll < findPercent) {
+            sink = (size_t)library.findBook(bookID);
+        } else if (roll < findPercent + searchPercent) {
+            page.clear();
+            library.fuzzyFindBook(WORDS[step / 100 % WORD_COUNT], nullptr, true, 20, page);
+            sink = page.size();
+        } else {
+            int userID = (int)(step / 7 % users) + 1;
+            auto lock = library.writeLock();
+            Node<UserInfo> *user = library.findUser(userID);
+            Node<BookInfo> *book = library.findBook(bookID);
+            if (library.hasBorrowed(user, book)) {
+                library.returnBook(user, book);
+            } else if (book->elem.readers.size() < book->elem.quantity) {
+                library.borrowBook(user, book);
+            }
+        }
+    });
+}
+
+void benchLibrary(int n) {
+    std::mt19937 random(n);
+    int users = std::max(1, n / 10);
+    fprintf(stderr, "%d 本图书，%d 名用户\n", n, users);
+    benchList(n, random);
+
+    auto library = std::make_unique<Library>();
+    measure("Library.add(BookInfo)", n, 16, false, [](uint64_t) {}, [&](uint64_t i) {
+        library->add(BookInfo(bookName((int)i + 1), (int)i + 1, 3));
+    });
+    measure("Library.add(UserInfo)", users, 16, false, [](uint64_t) {}, [&](uint64_t i) {
+        library->add(UserInfo("读者" + std::to_string(i + 1), "123456", (int)i + 1, i == 0 ? 1 : 0));
+    });
+
+    std::vector<int> bookIDs(1000000), userIDs(1000000);
+    for (int &id : bookIDs) id = (int)(random() % n) + 1;
+    for (int &id : userIDs) id = (int)(random() % users) + 1;
+    measure("Library.findBook(id)", bookIDs.size(), 16, [&](uint64_t i) {
+        sink = (size_t)library->findBook(bookIDs[i]);
+    });
+    measure("Library.findUser(id)", userIDs.size(), 16, [&](uint64_t i) {
+        sink = (size_t)library->findUser(userIDs[i]);
+    });
+    std::vector<string> names(100000);
+    for (size_t i = 0; i < names.size(); i++) names[i] = bookName(bookIDs[i]);
+    measure("Library.findBook(name)", names.size(), 16, [&](uint64_t i) {
+        sink = (size_t)library->findBook(names[i]);
+    });
+    measure("Library.fuzzyFindBook", 100000, 1, [&](uint64_t i) {
+        sink = library->fuzzyFindBook(WORDS[bookIDs[i] % WORD_COUNT]).size();
+    });
+    std::vector<Node<BookInfo>*> page;
+    measure("Library.fuzzyFindBook(page)", 100000, 1, [&](uint64_t i) {
+        page.clear();
+        library->fuzzyFindBook(WORDS[bookIDs[i] % WORD_COUNT], nullptr, true, 20, page);
+        sink = page.size();
+    });
+    measure("Library.fuzzyFindBook(miss)", 100000, 1, [&](uint64_t i) {
+        sink = library->fuzzyFindBook("不存在" + std::to_string(i)).size();
+    });
+
+    // 借还：每本书至多借出一次，不会因借完而失败；只还一半，其余留到数据文件中供读取时链接
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++) order[i] = i + 1;
+    std::shuffle(order.begin(), order.end(), random);
+    uint64_t borrowed = measure("Library.borrowBook", n, 1, [&](uint64_t i) {
+        sink = library->borrowBook(userIDs[i % userIDs.size()], order[i]);
+    });
+    measure("Library.returnBook", borrowed / 2, 1, [&](uint64_t i) {
+        sink = library->returnBook(userIDs[i % userIDs.size()], order[i]);
+    });
+
+    int heavy = n >= 1000000 ? 3 : n >= 100000 ? 5 : 20;
+    measure("Library.writeBook", heavy, 1, [&](uint64_t) { sink = library->writeBook(BOOK_FILE); });
+    measure("Library.writeUser", heavy, 1, [&](uint64_t) { sink = library->writeUser(USER_FILE); });
+    library.reset();
+
+    // 读取：先从 csv，写出快照后再从快照；库的创建与释放不计入
+    std::unique_ptr<Library> loaded;
+    auto fresh = [&](uint64_t) {
+        loaded.reset();
+        loaded = std::make_unique<Library>();
+    };
+    std::remove(snapshot::pathFor(BOOK_FILE).c_str());
+    measure("Library.read(csv)", heavy, 1, true, fresh, [&](uint64_t) { sink = loaded->read(USER_FILE, BOOK_FILE); });
+    loaded->write(USER_FILE, BOOK_FILE);
+    measure("Library.read(snapshot)", heavy, 1, true, fresh, [&](uint64_t) {
+        sink = loaded->read(USER_FILE, BOOK_FILE);
+    });
+
+    // 混合负载在读入的库上进行，借还同时追加日志
+    benchCirculation("circulation(lookup-heavy)", *loaded, users, 80, 10, random);
+    benchCirculation("circulation(borrow-heavy)", *loaded, users, 30, 10, random);
+    if (loaded->checkLoans()) fprintf(stderr, "  [警告] 借阅记录不一致\n");
+    loaded->discard();
+    loaded.reset();
+    removeFiles();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) budget = atof(argv[1]);
+    std::vector<int> sizes;
+    for (int i = 2; i < argc; i++) sizes.push_back(atoi(argv[i]));
+    if (sizes.empty()) sizes = {10000, 100000, 1000000};
+
+    for (int n : sizes) {
+        records = n;
+        benchLibrary(n);
+    }
+    printJson();
+    return 0;
+}
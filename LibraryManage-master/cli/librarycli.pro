@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = librarycli
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+include(../core/core.pri)
+
+SOURCES += \
+    main.cpp
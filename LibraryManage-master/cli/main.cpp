@@ -0,0 +1,354 @@
+// 命令行驱动：不经过图形界面读入数据文件，执行查询与增删改，或回放界面录制的操作记录（circtrace.h）
+// 用法：librarycli [选项] [命令 参数…]
+//   选项：--user=用户文件 --book=图书文件 --divide=分隔符 --dry-run（不保存任何改动）
+//         --record=文件（把执行的操作写入操作记录） --profile=文件（结束时写出性能统计 JSON）
+//   回放：librarycli [选项] replay 记录文件 [--rate=每秒操作数 | --speed=倍数] [--json] [--save]
+//         默认以最快速度依次执行；--rate 按固定速率，--speed 按记录中的时间间隔（除以倍数）执行。
+//         按计划执行时延迟从计划时刻算起，回放跟不上时排队的时间也计入。回放默认不保存改动，--save 时保存
+// 未给出命令时从标准输入逐行读取命令，参数以空白分隔，含空白的参数用双引号括起
+#include "circtrace.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+Library lib;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+std::unique_ptr<circtrace::Recorder> recorder;
+bool changed = false;		// 执行过成功的改动，结束时需要保存
+size_t limit = 100;			// 查找至多列出的结果数
+
+// 回放选项
+double rate = 0;			// 每秒操作数，为 0 时不按固定速率
+double speed = 0;			// 按记录中的时间间隔回放时的倍数，为 0 时不按记录的时间
+bool json = false;
+
+const char *HELP =
+    "命令：\n"
+    "  stats                               图书、用户与借阅数，并检查借阅记录\n"
+    "  book 编号 / user 编号                显示一条记录及其借阅\n"
+    "  findbook 名称 / finduser 名称         模糊查找（--limit=N 设定列出的结果数）\n"
+    "  borrow 用户编号 图书编号              借书\n"
+    "  return 用户编号 图书编号              还书\n"
+    "  addbook 名称 编号 数量\n"
+    "  adduser 用户名 密码 编号 类型\n"
+    "  delbook 编号 是否强制 / deluser 编号 是否强制\n"
+    "  editbook 原编号 名称 编号 数量\n"
+    "  edituser 原编号 用户名 密码 编号 类型\n"
+    "  replay 记录文件                      回放操作记录并报告吞吐量与延迟分位数\n"
+    "  save                                立即保存\n"
+    "  help                                显示本说明\n";
+
+bool option(const char *arg, const char *name, const char *&value) {
+    size_t length = strlen(name);
+    if (strncmp(arg, name, length) || arg[length] != '=') return false;
+    value = arg + length + 1;
+    return true;
+}
+// 按空白切分一行命令，双引号内的空白不切分
+std::vector<std::string> split(const std::string &line) {
+    std::vector<std::string> args;
+    std::string current;
+    bool quoted = false, started = false;
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            started = true;
+        } else if (!quoted && (c == ' ' || c == '\t' || c == '\r')) {
+            if (started) args.push_back(current);
+            current.clear();
+            started = false;
+        } else {
+            current += c;
+            started = true;
+        }
+    }
+    if (started) args.push_back(current);
+    return args;
+}
+
+void printBook(Node<BookInfo> *book) {
+    printf("%d\t%s\t馆藏 %d\t借出 %d\n", book->elem.identifier, book->elem.name.c_str(),
+           book->elem.quantity, book->elem.readers.size());
+}
+
+void printUser(Node<UserInfo> *user) {
+    printf("%d\t%s\t%s\t借阅 %d\n", user->elem.identifier, user->elem.name.c_str(),
+           user->elem.type == 1 ? "管理员" : "读者", user->elem.books.size());
+}
+
+void showBook(int id) {
+    auto lock = lib.readLock();
+    Node<BookInfo> *book = lib.findBook(id);
+    if (!book) {
+        printf("不存在编号为 %d 的图书。\n", id);
+        return;
+    }
+    printBook(book);
+    for (auto *p = book->elem.readers.begin(); p != book->elem.readers.end(); p = p->next) {
+        if (p->elem.user) {
+            printf("  ");
+            printUser(p->elem.user);
+        }
+    }
+}
+
+void showUser(int id) {
+    auto lock = lib.readLock();
+    Node<UserInfo> *user = lib.findUser(id);
+    if (!user) {
+        printf("不存在编号为 %d 的用户。\n", id);
+        return;
+    }
+    printUser(user);
+    for (auto *p = user->elem.books.begin(); p != user->elem.books.end(); p = p->next) {
+        if (p->elem.book) {
+            printf("  ");
+            printBook(p->elem.book);
+        }
+    }
+}
+// 列出至多 limit 条名称包含 name 的记录，多取一条以判断是否还有更多
+template<class T>
+void showSearch(const std::string &name) {
+    auto lock = lib.readLock();
+    std::vector<Node<T>*> found;
+    if constexpr (std::is_same<T, BookInfo>::value) {
+        if (recorder) recorder->findBook(name);
+        lib.fuzzyFindBook(name, nullptr, true, limit + 1, found);
+        for (size_t i = 0; i < found.size() && i < limit; i++) printBook(found[i]);
+    } else {
+        if (recorder) recorder->findUser(name);
+        lib.fuzzyFindUser(name, nullptr, true, limit + 1, found);
+        for (size_t i = 0; i < found.size() && i < limit; i++) printUser(found[i]);
+    }
+    if (found.size() > limit) printf("……（只列出前 %zu 条）\n", limit);
+    else if (found.empty()) printf("没有找到。\n");
+}
+
+// 等到 due；线程唤醒通常要晚几十微秒，最后 200 微秒改为忙等，以免高速率下计划时刻普遍推迟
+void waitUntil(Clock::time_point due) {
+    const auto spin = std::chrono::microseconds(200);
+    Clock::time_point now = Clock::now();
+    if (due - now > spin) std::this_thread::sleep_until(due - spin);
+    while (Clock::now() < due) std::this_thread::yield();
+}
+
+uint64_t percentile(const std::vector<uint64_t> &sorted, double q) {
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, (size_t)(q * sorted.size()))];
+}
+// 回放记录文件中的操作，按操作类型报告次数、失败数与延迟分位数
+int replay(const char *fileName) {
+    std::vector<circtrace::Event> events;
+    int badLine;
+    if (circtrace::read(fileName, events, &badLine)) {
+        if (badLine) fprintf(stderr, "操作记录 %s 第 %d 行格式错误。\n", fileName, badLine);
+        else fprintf(stderr, "无法读取操作记录 %s。\n", fileName);
+        return 1;
+    }
+    if (events.empty()) {
+        fprintf(stderr, "操作记录 %s 中没有操作。\n", fileName);
+        return 1;
+    }
+    fprintf(stderr, "回放 %zu 项操作……\n", events.size());
+
+    struct Stats {
+        std::vector<uint64_t> latency;	// 各次的纳秒数
+        uint64_t failed = 0;
+        uint64_t found = 0;				// 查找取得的结果总数
+    };
+    std::array<Stats, circtrace::OP_COUNT> stats;
+    bool paced = rate > 0 || speed > 0;
+    int64_t first = events[0].time;
+    // 失败的操作计入统计，引擎逐条输出的错误信息在回放期间不显示，以免拖慢回放
+    std::streambuf *errors = cerr.rdbuf(nullptr);
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < events.size(); i++) {
+        const circtrace::Event &event = events[i];
+        Clock::time_point begin;
+        if (paced) {
+            double offset = rate > 0 ? i * 1e9 / rate : (event.time - first) * 1e3 / speed;
+            begin = start + std::chrono::nanoseconds((int64_t)offset);
+            waitUntil(begin);
+        } else {
+            begin = Clock::now();
+        }
+        size_t found = 0;
+        int state = circtrace::apply(lib, event, &found);
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+        Stats &op = stats[event.op];
+        op.latency.push_back(ns);
+        op.found += found;
+        if (state) op.failed++;
+        else if (event.op != circtrace::FIND_BOOK && event.op != circtrace::FIND_USER) changed = true;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    cerr.rdbuf(errors);
+    cerr.clear();
+
+    const char *mode = rate > 0 ? "rate" : speed > 0 ? "speed" : "max";
+    if (json) {
+        std::string name;
+        for (const char *c = fileName; *c; c++) {
+            if (*c == '"' || *c == '\\') name += '\\';
+            name += *c;
+        }
+        printf("{\n  \"trace\": \"%s\",\n  \"mode\": \"%s\",\n  \"rate\": %g,\n  \"speed\": %g,\n"
+               "  \"ops\": %zu,\n  \"seconds\": %.6f,\n  \"opsPerSec\": %.1f,\n  \"results\": [",
+               name.c_str(), mode, rate, speed, events.size(), seconds, events.size() / seconds);
+        bool firstResult = true;
+        for (int i = 0; i < circtrace::OP_COUNT; i++) {
+            std::vector<uint64_t> &latency = stats[i].latency;
+            if (latency.empty()) continue;
+            std::sort(latency.begin(), latency.end());
+            printf("%s\n    {\"op\": \"%s\", \"count\": %zu, \"failed\": %llu, \"found\": %llu, "
+                   "\"latencyNs\": {\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu}}",
+                   firstResult ? "" : ",", circtrace::OP_NAMES[i], latency.size(),
+                   (unsigned long long)stats[i].failed, (unsigned long long)stats[i].found,
+                   (unsigned long long)percentile(latency, 0.5), (unsigned long long)percentile(latency, 0.9),
+                   (unsigned long long)percentile(latency, 0.99), (unsigned long long)percentile(latency, 0.999),
+                   (unsigned long long)latency.back());
+            firstResult = false;
+        }
+        printf("\n  ]\n}\n");
+    } else {
+        printf("%-10s %10s %8s %10s %10s %10s %10s %10s\n", "操作", "次数", "失败",
+               "P50(µs)", "P90(µs)", "P99(µs)", "P99.9(µs)", "最长(µs)");
+        for (int i = 0; i < circtrace::OP_COUNT; i++) {
+            std::vector<uint64_t> &latency = stats[i].latency;
+            if (latency.empty()) continue;
+            std::sort(latency.begin(), latency.end());
+            printf("%-10s %10zu %8llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", circtrace::OP_NAMES[i],
+                   latency.size(), (unsigned long long)stats[i].failed,
+                   percentile(latency, 0.5) / 1e3, percentile(latency, 0.9) / 1e3,
+                   percentile(latency, 0.99) / 1e3, percentile(latency, 0.999) / 1e3, latency.back() / 1e3);
+        }
+        printf("共 %zu 项操作，用时 %.3f 秒，%.0f 次/秒\n", events.size(), seconds, events.size() / seconds);
+    }
+    return 0;
+}
+// 执行一条命令，成功返回 0
+int run(const std::vector<std::string> &args) {
+    const std::string &command = args[0];
+    int id;
+    if (command == "help") {
+        printf("%s", HELP);
+    } else if (command == "stats") {
+        auto lock = lib.readLock();
+        long long loans = 0;
+        for (auto *p = lib.users.begin(); p != lib.users.end(); p = p->next) loans += p->elem.books.size();
+        printf("图书 %d 种，用户 %d 名，借阅 %lld 条\n", lib.books.size(), lib.users.size(), loans);
+        if (lib.checkLoans()) {
+            printf("借阅记录不一致。\n");
+            return 1;
+        }
+    } else if ((command == "book" || command == "user") && args.size() == 2 && circtrace::toInt(args[1], id)) {
+        if (command == "book") showBook(id);
+        else showUser(id);
+    } else if ((command == "findbook" || command == "finduser") && args.size() == 2) {
+        if (command == "findbook") showSearch<BookInfo>(args[1]);
+        else showSearch<UserInfo>(args[1]);
+    } else if (command == "replay" && args.size() == 2) {
+        return replay(args[1].c_str());
+    } else if (command == "save" && args.size() == 1) {
+        if (lib.save()) return 1;
+        changed = false;
+    } else {
+        circtrace::Event event;
+        if (circtrace::parse(args, event)) {
+            fprintf(stderr, "无法识别的命令或参数有误：%s（help 显示可用的命令）\n", command.c_str());
+            return 1;
+        }
+        if (circtrace::apply(lib, event)) {
+            printf("失败。\n");
+            return 1;
+        }
+        changed = true;
+        printf("完成。\n");
+    }
+    return 0;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const char *userFile = "user.csv";
+    const char *bookFile = "book.csv";
+    const char *recordFile = nullptr;
+    const char *profileFile = nullptr;
+    char divide = ',';
+    bool dryRun = false, save = false;
+    std::vector<std::string> command;
+    for (int i = 1; i < argc; i++) {
+        const char *value;
+        if (option(argv[i], "--user", value)) userFile = value;
+        else if (option(argv[i], "--book", value)) bookFile = value;
+        else if (option(argv[i], "--divide", value)) divide = value[0];
+        else if (option(argv[i], "--record", value)) recordFile = value;
+        else if (option(argv[i], "--profile", value)) profileFile = value;
+        else if (option(argv[i], "--limit", value)) limit = strtoull(value, nullptr, 10);
+        else if (option(argv[i], "--rate", value)) rate = atof(value);
+        else if (option(argv[i], "--speed", value)) speed = atof(value);
+        else if (!strcmp(argv[i], "--json")) json = true;
+        else if (!strcmp(argv[i], "--dry-run")) dryRun = true;
+        else if (!strcmp(argv[i], "--save")) save = true;
+        else if (!strncmp(argv[i], "--", 2)) {
+            fprintf(stderr, "无法识别的参数 %s\n", argv[i]);
+            return 1;
+        } else {
+            command.push_back(argv[i]);
+        }
+    }
+    if (rate < 0 || speed < 0 || (rate > 0 && speed > 0)) {
+        fprintf(stderr, "--rate 与 --speed 应为正数，且只能给出其中一个。\n");
+        return 1;
+    }
+    if (!command.empty() && command[0] == "replay" && !save) dryRun = true;
+
+    lib.DIVIDE_CHAR = divide;
+    if (lib.read(userFile, bookFile)) {
+        fprintf(stderr, "[警告] 以空数据开始，保存时将写入 %s 与 %s。\n", userFile, bookFile);
+    }
+    if (dryRun) lib.detachJournal();
+    if (recordFile) {
+        recorder = std::make_unique<circtrace::Recorder>(lib);
+        if (recorder->start(recordFile)) {
+            fprintf(stderr, "无法写入操作记录 %s。\n", recordFile);
+            return 1;
+        }
+    }
+
+    int state = 0;
+    if (!command.empty()) {
+        state = run(command);
+    } else {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            std::vector<std::string> args = split(line);
+            if (args.empty() || args[0][0] == '#') continue;
+            if (args[0] == "quit" || args[0] == "exit") break;
+            state = run(args);
+            fflush(stdout);
+        }
+    }
+
+    if (recorder && recorder->stop()) {
+        fprintf(stderr, "[警告] 操作记录 %s 写入失败。\n", recordFile);
+    }
+    if (profileFile && profiler::writeJson(profileFile)) {
+        fprintf(stderr, "[警告] 无法写入性能统计 %s。\n", profileFile);
+    }
+    if (changed && !dryRun && lib.save()) {
+        fprintf(stderr, "[警告] 保存失败。\n");
+        return 1;
+    }
+    return state;
+}
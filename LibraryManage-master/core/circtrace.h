@@ -0,0 +1,412 @@
+#ifndef CIRCTRACE_H
+#define CIRCTRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "librarydata.h"
+
+// 借还操作记录（.trace）：借还、查找与增删改按发生顺序逐行记下，供离线回放以重现实际负载
+// 文本格式，首行为 "# librarytrace 1"，其余以 # 开头的行为注释；
+// 每行依次为相对开始记录时的微秒数、操作名与参数，以制表符分隔，名称中的 \ 、制表符与换行转义为 \\、\t、\n
+// 操作名与参数的写法与 librarycli 的命令相同：
+//   borrow 用户编号 图书编号        return 用户编号 图书编号
+//   findbook 名称                  finduser 名称
+//   addbook 名称 编号 数量          adduser 用户名 密码 编号 类型
+//   delbook 编号 是否强制           deluser 编号 是否强制
+//   editbook 原编号 名称 编号 数量   edituser 原编号 用户名 密码 编号 类型
+namespace circtrace {
+
+enum Op {
+    BORROW,
+    RETURN,
+    FIND_BOOK,
+    FIND_USER,
+    ADD_BOOK,
+    ADD_USER,
+    DEL_BOOK,
+    DEL_USER,
+    EDIT_BOOK,
+    EDIT_USER,
+    OP_COUNT
+};
+
+constexpr const char *OP_NAMES[OP_COUNT] = {
+    "borrow", "return", "findbook", "finduser", "addbook",
+    "adduser", "delbook", "deluser", "editbook", "edituser"
+};
+
+constexpr const char *HEADER = "# librarytrace 1";
+constexpr size_t SEARCH_LIMIT = 101;	// 查找取得的结果数，与界面查找一页相同（100 条，多取一条判断能否翻页）
+
+struct Event {
+    int64_t time = 0;		// 相对开始记录时的微秒数
+    Op op = BORROW;
+    std::string name;		// 名称、用户名或查找内容
+    std::string password;
+    int oldID = 0;			// edit 的原编号
+    int id = 0;				// 图书或用户编号；借还时为用户编号
+    int value = 0;			// 借还时为图书编号，其余为数量、类型或是否强制
+};
+
+inline int opOf(const std::string &name) {
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (name == OP_NAMES[op]) return op;
+    }
+    return -1;
+}
+
+inline bool toInt(const std::string &text, int &value) {
+    if (text.empty()) return false;
+    char *end;
+    long parsed = strtol(text.c_str(), &end, 10);
+    if (*end || parsed < INT_MIN || parsed > INT_MAX) return false;
+    value = (int)parsed;
+    return true;
+}
+// 由操作名与参数构造操作，args[0] 为操作名；参数个数或格式不对时返回 1
+inline int parse(const std::vector<std::string> &args, Event &event) {
+    if (args.empty()) return 1;
+    int op = opOf(args[0]);
+    if (op < 0) return 1;
+    event.op = (Op)op;
+    size_t count = args.size() - 1;
+    switch (event.op) {
+    case BORROW:
+    case RETURN:
+        return count == 2 && toInt(args[1], event.id) && toInt(args[2], event.value) ? 0 : 1;
+    case FIND_BOOK:
+    case FIND_USER:
+        if (count != 1) return 1;
+        event.name = args[1];
+        return 0;
+    case ADD_BOOK:
+        if (count != 3) return 1;
+        event.name = args[1];
+        return toInt(args[2], event.id) && toInt(args[3], event.value) ? 0 : 1;
+    case ADD_USER:
+        if (count != 4) return 1;
+        event.name = args[1];
+        event.password = args[2];
+        return toInt(args[3], event.id) && toInt(args[4], event.value) ? 0 : 1;
+    case DEL_BOOK:
+    case DEL_USER:
+        return count == 2 && toInt(args[1], event.id) && toInt(args[2], event.value) ? 0 : 1;
+    case EDIT_BOOK:
+        if (count != 4 || !toInt(args[1], event.oldID)) return 1;
+        event.name = args[2];
+        return toInt(args[3], event.id) && toInt(args[4], event.value) ? 0 : 1;
+    case EDIT_USER:
+        if (count != 5 || !toInt(args[1], event.oldID)) return 1;
+        event.name = args[2];
+        event.password = args[3];
+        return toInt(args[4], event.id) && toInt(args[5], event.value) ? 0 : 1;
+    default:
+        return 1;
+    }
+}
+
+inline void escape(std::string &line, const std::string &text) {
+    for (char c : text) {
+        if (c == '\\') line += "\\\\";
+        else if (c == '\t') line += "\\t";
+        else if (c == '\n') line += "\\n";
+        else line += c;
+    }
+}
+
+inline std::string unescape(const std::string &text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] != '\\' || i + 1 == text.size()) {
+            out += text[i];
+            continue;
+        }
+        char c = text[++i];
+        out += c == 't' ? '\t' : c == 'n' ? '\n' : c;
+    }
+    return out;
+}
+// 生成一行记录（不含换行）
+inline std::string format(const Event &event) {
+    std::string line = std::to_string(event.time);
+    line += '\t';
+    line += OP_NAMES[event.op];
+    auto text = [&line](const std::string &value) {
+        line += '\t';
+        escape(line, value);
+    };
+    auto number = [&line](int value) {
+        line += '\t';
+        line += std::to_string(value);
+    };
+    switch (event.op) {
+    case FIND_BOOK:
+    case FIND_USER:
+        text(event.name);
+        break;
+    case ADD_BOOK:
+        text(event.name);
+        number(event.id);
+        number(event.value);
+        break;
+    case ADD_USER:
+        text(event.name);
+        text(event.password);
+        number(event.id);
+        number(event.value);
+        break;
+    case EDIT_BOOK:
+        number(event.oldID);
+        text(event.name);
+        number(event.id);
+        number(event.value);
+        break;
+    case EDIT_USER:
+        number(event.oldID);
+        text(event.name);
+        text(event.password);
+        number(event.id);
+        number(event.value);
+        break;
+    default:
+        number(event.id);
+        number(event.value);
+        break;
+    }
+    return line;
+}
+// 读入整个记录文件；失败时返回 1，格式错误时 badLine 为出错的行号
+inline int read(const char *fileName, std::vector<Event> &events, int *badLine = nullptr) {
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in) return 1;
+    std::string line;
+    int number = 0;
+    if (badLine) *badLine = 0;
+    while (std::getline(in, line)) {
+        number++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        std::vector<std::string> fields;
+        size_t begin = 0;
+        for (;;) {
+            size_t end = line.find('\t', begin);
+            fields.push_back(unescape(line.substr(begin, end == std::string::npos ? end : end - begin)));
+            if (end == std::string::npos) break;
+            begin = end + 1;
+        }
+        Event event;
+        char *end;
+        event.time = strtoll(fields[0].c_str(), &end, 10);
+        bool valid = !*end && !fields[0].empty();
+        fields.erase(fields.begin());
+        if (!valid || fields.empty() || parse(fields, event)) {
+            if (badLine) *badLine = number;
+            return 1;
+        }
+        events.push_back(std::move(event));
+    }
+    return 0;
+}
+// 对 library 执行一项操作，成功返回 0；查找时 found 为取得的结果数
+// 与 Library::replayRecord 相同，按编号找到记录后调用对应的方法
+inline int apply(Library &library, const Event &event, size_t *found = nullptr) {
+    switch (event.op) {
+    case BORROW:
+        return library.borrowBook(library.findUser(event.id), library.findBook(event.value));
+    case RETURN:
+        return library.returnBook(library.findUser(event.id), library.findBook(event.value));
+    case FIND_BOOK: {
+        std::vector<Node<BookInfo>*> out;
+        library.fuzzyFindBook(event.name, nullptr, true, SEARCH_LIMIT, out);
+        if (found) *found = out.size();
+        return 0;
+    }
+    case FIND_USER: {
+        std::vector<Node<UserInfo>*> out;
+        library.fuzzyFindUser(event.name, nullptr, true, SEARCH_LIMIT, out);
+        if (found) *found = out.size();
+        return 0;
+    }
+    case ADD_BOOK: {
+        // 与服务端相同，编号重复等无效的改动不执行
+        auto lock = library.writeLock();
+        BookInfo book(event.name, event.id, event.value);
+        return library.canAdd(book) && library.add(book) ? 0 : 1;
+    }
+    case ADD_USER: {
+        auto lock = library.writeLock();
+        UserInfo user(event.name, event.password, event.id, event.value);
+        return library.canAdd(user) && library.add(user) ? 0 : 1;
+    }
+    case DEL_BOOK: {
+        auto lock = library.writeLock();
+        Node<BookInfo> *book = library.findBook(event.id);
+        return book && library.del(book, event.value != 0) ? 0 : 1;
+    }
+    case DEL_USER: {
+        auto lock = library.writeLock();
+        Node<UserInfo> *user = library.findUser(event.id);
+        return user && library.del(user, event.value != 0) ? 0 : 1;
+    }
+    case EDIT_BOOK: {
+        auto lock = library.writeLock();
+        Node<BookInfo> *book = library.findBook(event.oldID);
+        BookInfo target(event.name, event.id, event.value);
+        return book && library.canModify(book, target) && library.modify(book, target) ? 0 : 1;
+    }
+    case EDIT_USER: {
+        auto lock = library.writeLock();
+        Node<UserInfo> *user = library.findUser(event.oldID);
+        UserInfo target(event.name, event.password, event.id, event.value);
+        return user && library.canModify(user, target) && library.modify(user, target) ? 0 : 1;
+    }
+    default:
+        return 1;
+    }
+}
+
+// 把 Library 的改动与调用者报告的查找写入记录文件
+// 借还与增删改由通知取得，来自任何线程的改动都会记下；查找不经过通知，由调用者调用 findBook / findUser
+// 强制删除时先逐条发出归还的通知，因此记为若干 return 之后的普通删除；修改按修改后的完整内容记为 edit
+class Recorder : public LibraryListener {
+public:
+    explicit Recorder(Library &library): library(library), recording(false), count(0) {}
+
+    ~Recorder() {
+        stop();
+    }
+
+    Recorder(const Recorder &) = delete;
+    Recorder &operator =(const Recorder &) = delete;
+    // 开始写入 fileName（覆盖原有内容），成功返回 0
+    int start(const char *fileName) {
+        stop();
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            out.open(fileName, std::ios::binary | std::ios::trunc);
+            if (!out) return 1;
+            out << HEADER << '\n';
+            begin = std::chrono::steady_clock::now();
+            count = 0;
+            recording = true;
+        }
+        library.addListener(this);
+        return 0;
+    }
+    // 停止记录并关闭文件，返回写入是否成功（0 为成功）
+    int stop() {
+        if (!recording) return 0;
+        library.removeListener(this);
+        std::lock_guard<std::mutex> guard(mutex);
+        recording = false;
+        out.close();
+        return out.fail() ? 1 : 0;
+    }
+
+    bool isRecording() const {
+        return recording;
+    }
+    // 已记下的操作数
+    size_t size() const {
+        return count;
+    }
+
+    void findBook(const std::string &name) {
+        Event event;
+        event.op = FIND_BOOK;
+        event.name = name;
+        write(event);
+    }
+
+    void findUser(const std::string &name) {
+        Event event;
+        event.op = FIND_USER;
+        event.name = name;
+        write(event);
+    }
+
+    void bookAdded(Node<BookInfo> *book) override {
+        write(bookEvent(ADD_BOOK, book->elem.identifier, book));
+    }
+
+    void userAdded(Node<UserInfo> *user) override {
+        write(userEvent(ADD_USER, user->elem.identifier, user));
+    }
+
+    void bookRemoved(Node<BookInfo> *book) override {
+        write(idEvent(DEL_BOOK, book->elem.identifier, 0));
+    }
+
+    void userRemoved(Node<UserInfo> *user) override {
+        write(idEvent(DEL_USER, user->elem.identifier, 0));
+    }
+
+    void bookChanged(int oldID, Node<BookInfo> *book) override {
+        write(bookEvent(EDIT_BOOK, oldID, book));
+    }
+
+    void userChanged(int oldID, Node<UserInfo> *user) override {
+        write(userEvent(EDIT_USER, oldID, user));
+    }
+
+    void loanAdded(Node<UserInfo> *user, Node<BookInfo> *book) override {
+        write(idEvent(BORROW, user->elem.identifier, book->elem.identifier));
+    }
+
+    void loanRemoved(Node<UserInfo> *user, Node<BookInfo> *book) override {
+        write(idEvent(RETURN, user->elem.identifier, book->elem.identifier));
+    }
+
+private:
+    Library &library;
+    std::mutex mutex;
+    std::ofstream out;
+    std::chrono::steady_clock::time_point begin;	// 开始记录的时刻
+    std::atomic<bool> recording;
+    std::atomic<size_t> count;
+
+    static Event idEvent(Op op, int id, int value) {
+        Event event;
+        event.op = op;
+        event.id = id;
+        event.value = value;
+        return event;
+    }
+
+    static Event bookEvent(Op op, int oldID, Node<BookInfo> *book) {
+        Event event = idEvent(op, book->elem.identifier, book->elem.quantity);
+        event.oldID = oldID;
+        event.name = book->elem.name;
+        return event;
+    }
+
+    static Event userEvent(Op op, int oldID, Node<UserInfo> *user) {
+        Event event = idEvent(op, user->elem.identifier, user->elem.type);
+        event.oldID = oldID;
+        event.name = user->elem.name;
+        event.password = user->elem.password;
+        return event;
+    }
+
+    void write(Event event) {
+        if (!recording) return;
+        std::lock_guard<std::mutex> guard(mutex);
+        if (!recording) return;
+        event.time = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - begin).count();
+        out << format(event) << '\n';
+        count++;
+    }
+};
+
+}
+
+#endif // CIRCTRACE_H
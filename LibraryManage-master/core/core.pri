@@ -0,0 +1,24 @@
+# 数据引擎 librarycore：只用标准库与各平台的文件、线程接口，可在 Windows 与 Linux 下编译
+# 界面、借还服务与基准程序包含本文件即可使用引擎的头文件并链接 librarycore
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+# 引擎在 Windows 下包含 Windows.h，关闭其 min/max 宏以免与 std::min/std::max 冲突
+win32: DEFINES += NOMINMAX
+
+# 热点路径（csv 解析、索引、链表、模糊查找）大多是头文件中的模板，使用方与引擎按同样的选项优化
+!msvc {
+    QMAKE_CXXFLAGS_RELEASE -= -O2
+    QMAKE_CXXFLAGS_RELEASE *= -O3
+}
+
+!equals(TARGET, librarycore) {
+    CORE_OUT = $$shadowed($$PWD)
+    win32:CONFIG(release, debug|release): CORE_OUT = $$CORE_OUT/release
+    else:win32:CONFIG(debug, debug|release): CORE_OUT = $$CORE_OUT/debug
+
+    LIBS += -L$$CORE_OUT -llibrarycore
+    win32:!win32-g++: PRE_TARGETDEPS += $$CORE_OUT/librarycore.lib
+    else: PRE_TARGETDEPS += $$CORE_OUT/liblibrarycore.a
+}
@@ -0,0 +1,25 @@
+TEMPLATE = lib
+TARGET = librarycore
+CONFIG += staticlib c++17
+CONFIG -= qt
+
+include(core.pri)
+
+SOURCES += \
+    librarydata.cpp
+
+HEADERS += \
+    circtrace.h \
+    csvreader.h \
+    csvwriter.h \
+    hashindex.h \
+    journal.h \
+    librarydata.h \
+    ngramindex.h \
+    nodepool.h \
+    profiler.h \
+    protocol.h \
+    rwlock.h \
+    savejob.h \
+    searchjob.h \
+    snapshot.h
@@ -0,0 +1,239 @@
+#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 只读内存映射文件，整个文件映射为一段连续内存，读取时不再逐行复制
+class MappedFile {
+public:
+    MappedFile(): base(nullptr), length(0) {}
+
+    explicit MappedFile(const char *fileName): base(nullptr), length(0) {
+        open(fileName);
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator =(const MappedFile &) = delete;
+    // 映射文件，成功返回 true；空文件也视为成功
+    bool open(const char *fileName) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            return false;
+        }
+        length = (size_t)fileSize.QuadPart;
+        if (length) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                base = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        int fd = ::open(fileName, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) < 0) {
+            ::close(fd);
+            return false;
+        }
+        length = (size_t)st.st_size;
+        if (length) {
+            void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                base = (const char *)p;
+                madvise(p, length, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+#endif
+        if (length && !base) {
+            length = 0;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (base) {
+#ifdef _WIN32
+            UnmapViewOfFile(base);
+#else
+            munmap((void *)base, length);
+#endif
+        }
+        base = nullptr;
+        length = 0;
+    }
+
+    const char *data() const {
+        return base;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    std::string_view view() const {
+        return std::string_view(base, length);
+    }
+
+private:
+    const char *base;
+    size_t length;
+};
+
+// 原地切分 csv 文本，字段以 string_view 返回，指向原缓冲区，不做任何复制
+class CsvCursor {
+public:
+    CsvCursor(std::string_view text, char divide): rest(text), divide(divide) {}
+    // 取下一行（不含换行符与行尾的 '\r'），到达末尾返回 false
+    bool nextLine(std::string_view &line) {
+        if (rest.empty()) return false;
+        size_t end = rest.find('\n');
+        if (end == std::string_view::npos) {
+            line = rest;
+            rest = std::string_view();
+        } else {
+            line = rest.substr(0, end);
+            rest.remove_prefix(end + 1);
+        }
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        return true;
+    }
+    // 从行中取下一个字段并将其移出该行，行已取完返回 false
+    bool nextField(std::string_view &line, std::string_view &field) const {
+        if (line.data() == nullptr) return false;
+        size_t end = line.find(divide);
+        if (end == std::string_view::npos) {
+            field = line;
+            line = std::string_view();
+        } else {
+            field = line.substr(0, end);
+            line.remove_prefix(end + 1);
+        }
+        return true;
+    }
+    // 按 atoi 的规则解析整数：跳过前导空白，允许正负号，遇到非数字即停止，无法解析时返回 0
+    static int toInt(std::string_view field) {
+        size_t i = 0;
+        while (i < field.size() && isspace((unsigned char)field[i])) i++;
+        if (i < field.size() && field[i] == '+') i++;
+        int value = 0;
+        if (std::from_chars(field.data() + i, field.data() + field.size(), value).ec != std::errc())
+            return 0;
+        return value;
+    }
+
+private:
+    std::string_view rest;	// 尚未读取的文本
+    char divide;			// 字段分隔符
+};
+
+// 数据文件中的一行：前若干个文本字段、两个整数字段，其后为借阅编号列表
+// 图书：名称, 编号, 数量, 读者编号...；用户：用户名, 密码, 编号, 类型, 图书编号...
+struct CsvRecord {
+    std::string_view line;		// 整行（不含换行符），指向映射的文件内容
+    std::string_view text[2];	// 文本字段
+    int number[2];				// 整数字段
+    size_t idBegin;				// 借阅编号在所属块 ids 中的范围
+    size_t idEnd;
+    bool skipped;				// 是否有无法解析而被忽略的借阅编号
+};
+
+// 文件的一块（若干完整行）及其解析结果
+struct CsvChunk {
+    std::string_view text;
+    std::vector<CsvRecord> records;
+    std::vector<int> ids;
+
+    // 解析本块，textFields 为行首文本字段个数
+    void parse(char divide, int textFields) {
+        CsvCursor csv(text, divide);
+        std::string_view line, field;
+        while (csv.nextLine(line)) {
+            if (line.empty()) continue;	// 若读到空行则跳过
+            CsvRecord record = {};
+            record.line = line;
+            record.idBegin = ids.size();
+            for (int cnt = 0; csv.nextField(line, field); cnt++) {
+                if (cnt < textFields) {
+                    record.text[cnt] = field;
+                } else if (cnt < textFields + 2) {
+                    record.number[cnt - textFields] = CsvCursor::toInt(field);
+                } else {
+                    int id = CsvCursor::toInt(field);
+                    if (id) ids.push_back(id);
+                    else record.skipped = true;
+                }
+            }
+            record.idEnd = ids.size();
+            records.push_back(record);
+        }
+    }
+};
+
+// 在行边界处把文本切成至多 n 块，每块不小于 minSize 字节
+inline std::vector<CsvChunk> splitChunks(std::string_view text, size_t n, size_t minSize = 1 << 18) {
+    std::vector<CsvChunk> chunks;
+    n = std::max<size_t>(1, std::min(n, text.size() / minSize));
+    size_t target = text.size() / n + 1;
+    while (!text.empty()) {
+        size_t end = text.size();
+        if (chunks.size() + 1 < n && target < text.size()) {
+            size_t nl = text.find('\n', target);
+            if (nl != std::string_view::npos) end = nl + 1;
+        }
+        CsvChunk chunk;
+        chunk.text = text.substr(0, end);
+        chunks.push_back(std::move(chunk));
+        text.remove_prefix(end);
+    }
+    return chunks;
+}
+
+// 用至多 hardware_concurrency 个工作线程执行全部任务，返回时任务均已完成
+inline void runParallel(const std::vector<std::function<void()>> &tasks) {
+    size_t workers = std::min<size_t>(tasks.size(), std::max(1u, std::thread::hardware_concurrency()));
+    if (workers <= 1) {
+        for (auto &task : tasks) task();
+        return;
+    }
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i; (i = next++) < tasks.size(); ) tasks[i]();
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; i++) threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads) thread.join();
+}
+
+#endif // CSVREADER_H
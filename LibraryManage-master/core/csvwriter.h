@@ -0,0 +1,112 @@
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// 带大缓冲区的 csv 写入
+// 内容先写入同目录下的临时文件（原文件名加 .tmp），commit() 落盘后以重命名整体替换目标文件，
+// 写入中途失败或未 commit 时目标文件保持原样
+class CsvWriter {
+public:
+    CsvWriter(const char *fileName, char divide):
+        target(fileName), temp(target + ".tmp"), divide(divide), written(0) {
+        file = fopen(temp.c_str(), "wb");
+        buffer.reserve(BUFFER_SIZE);
+    }
+
+    ~CsvWriter() {
+        if (file) {
+            fclose(file);
+            remove(temp.c_str());
+        }
+    }
+
+    CsvWriter(const CsvWriter &) = delete;
+    CsvWriter &operator =(const CsvWriter &) = delete;
+
+    bool isOpen() const {
+        return file != nullptr;
+    }
+    // 原样写入一段文本
+    void write(std::string_view text) {
+        if (buffer.size() + text.size() > BUFFER_SIZE) flush();
+        if (text.size() > BUFFER_SIZE) {
+            put(text.data(), text.size());
+        } else {
+            buffer.append(text.data(), text.size());
+        }
+        written += text.size();
+    }
+    // 写入分隔符及一个字段
+    void field(std::string_view text) {
+        write(std::string_view(&divide, 1));
+        write(text);
+    }
+
+    void field(int value) {
+        char digits[16];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        field(std::string_view(digits, result.ptr - digits));
+    }
+
+    void endLine() {
+        write("\n");
+    }
+    // 已写入的字节数，即下一个字节在文件中的位置
+    uint64_t offset() const {
+        return written;
+    }
+    // 写完全部内容后调用，成功返回 true
+    bool commit() {
+        if (!file) return false;
+        flush();
+        bool ok = !ferror(file) && fflush(file) == 0;
+#ifdef _WIN32
+        ok = ok && _commit(_fileno(file)) == 0;
+#else
+        ok = ok && fsync(fileno(file)) == 0;
+#endif
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        std::error_code ec;
+        if (ok) std::filesystem::rename(temp, target, ec);
+        if (!ok || ec) {
+            remove(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    std::string target;		// 目标文件
+    std::string temp;		// 临时文件
+    char divide;			// 字段分隔符
+    FILE *file;
+    std::string buffer;		// 尚未写入文件的内容
+    uint64_t written;
+
+    void flush() {
+        put(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+    void put(const char *data, size_t size) {
+        if (file && size) fwrite(data, 1, size, file);
+    }
+};
+
+#endif // CSVWRITER_H
@@ -0,0 +1,182 @@
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+// 索引键的哈希函数
+template<class K> struct IndexHash;
+
+template<> struct IndexHash<int> {
+    size_t operator ()(int key) const {
+        // 整数混合，避免连续编号聚集在相邻槽位
+        uint32_t h = (uint32_t)key;
+        h ^= h >> 16;
+        h *= 0x7feb352dU;
+        h ^= h >> 15;
+        h *= 0x846ca68bU;
+        h ^= h >> 16;
+        return h;
+    }
+};
+
+template<> struct IndexHash<uint64_t> {
+    size_t operator ()(uint64_t key) const {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return (size_t)key;
+    }
+};
+
+template<class T> struct IndexHash<T*> {
+    size_t operator ()(T *key) const {
+        return IndexHash<uint64_t>()((uint64_t)(uintptr_t)key);
+    }
+};
+
+template<class A, class B> struct IndexHash<std::pair<A, B>> {
+    size_t operator ()(const std::pair<A, B> &key) const {
+        size_t h = IndexHash<A>()(key.first);
+        return h ^ (IndexHash<B>()(key.second) + 0x9e3779b9U + (h << 6) + (h >> 2));
+    }
+};
+
+template<> struct IndexHash<std::string> {
+    size_t operator ()(const std::string &key) const {
+        // FNV-1a
+        uint64_t h = 14695981039346656037ULL;
+        for (unsigned char c : key) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        return (size_t)(h ^ (h >> 32));
+    }
+};
+
+// 开放寻址哈希表（线性探测），用于由键快速定位链表节点
+// 键已存在时 insert 不覆盖原值，与按链表顺序查找“第一个匹配节点”的语义一致
+template<class K, class V, class Hash = IndexHash<K>> class HashIndex {
+public:
+    HashIndex(): slots(nullptr), capacity(0), count(0) {}
+
+    ~HashIndex() {
+        delete[] slots;
+    }
+
+    HashIndex(const HashIndex &) = delete;
+    HashIndex &operator =(const HashIndex &) = delete;
+    // 查找键对应的值，不存在时返回 V()
+    V find(const K &key) const {
+        if (!count) return V();
+        for (size_t i = hash(key) & (capacity - 1); slots[i].used; i = (i + 1) & (capacity - 1)) {
+            if (slots[i].key == key) return slots[i].val;
+        }
+        return V();
+    }
+    // 查找键对应值的指针，不存在时返回空指针
+    V *get(const K &key) {
+        if (!count) return nullptr;
+        for (size_t i = hash(key) & (capacity - 1); slots[i].used; i = (i + 1) & (capacity - 1)) {
+            if (slots[i].key == key) return &slots[i].val;
+        }
+        return nullptr;
+    }
+    const V *get(const K &key) const {
+        return const_cast<HashIndex *>(this)->get(key);
+    }
+    // 返回键对应值的引用，键不存在时先插入默认值
+    V &obtain(const K &key) {
+        if (!count || !get(key)) insert(key, V());
+        return *get(key);
+    }
+    // 插入键值对，若键已存在则不修改并返回 false
+    bool insert(const K &key, V val) {
+        if ((count + 1) * 4 > capacity * 3) rehash(capacity ? capacity * 2 : 16);
+        size_t i = hash(key) & (capacity - 1);
+        for (; slots[i].used; i = (i + 1) & (capacity - 1)) {
+            if (slots[i].key == key) return false;
+        }
+        slots[i].key  = key;
+        slots[i].val  = std::move(val);
+        slots[i].used = true;
+        count++;
+        return true;
+    }
+    // 删除键，若提供 val 则仅在键映射到该值时删除
+    bool erase(const K &key) {
+        return eraseIf(key, nullptr);
+    }
+
+    bool erase(const K &key, V val) {
+        return eraseIf(key, &val);
+    }
+    // 预留空间，批量插入前调用可避免反复扩容
+    void reserve(size_t n) {
+        size_t need = 16;
+        while (need * 3 < n * 4) need *= 2;
+        if (need > capacity) rehash(need);
+    }
+
+    void clear() {
+        delete[] slots;
+        slots = nullptr;
+        capacity = 0;
+        count = 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+private:
+    struct Slot {
+        K key;
+        V val;
+        bool used = false;
+    };
+
+    Slot *slots;
+    size_t capacity;	// 槽位数，总为 2 的幂
+    size_t count;		// 已用槽位数
+    Hash hash;
+
+    bool eraseIf(const K &key, const V *val) {
+        if (!count) return false;
+        size_t i = hash(key) & (capacity - 1);
+        for (; slots[i].used; i = (i + 1) & (capacity - 1)) {
+            if (slots[i].key == key) break;
+        }
+        if (!slots[i].used || (val && !(slots[i].val == *val))) return false;
+        // 后移删除：把探测链上后续元素前移填补空位，无需墓碑标记
+        size_t hole = i;
+        for (size_t j = (i + 1) & (capacity - 1); slots[j].used; j = (j + 1) & (capacity - 1)) {
+            size_t home = hash(slots[j].key) & (capacity - 1);
+            if (((j - home) & (capacity - 1)) >= ((j - hole) & (capacity - 1))) {
+                slots[hole] = std::move(slots[j]);
+                hole = j;
+            }
+        }
+        slots[hole].used = false;
+        slots[hole].key  = K();
+        slots[hole].val  = V();
+        count--;
+        return true;
+    }
+
+    void rehash(size_t newCapacity) {
+        Slot *old = slots;
+        size_t oldCapacity = capacity;
+        slots = new Slot[newCapacity];
+        capacity = newCapacity;
+        count = 0;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (old[i].used) insert(old[i].key, std::move(old[i].val));
+        }
+        delete[] old;
+    }
+};
+
+#endif // HASHINDEX_H
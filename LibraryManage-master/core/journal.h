@@ -0,0 +1,421 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include "csvreader.h"
+#include "snapshot.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 借还与增删改操作的追加式日志（.lbj）
+// 文件头记录其所基于的那次完整保存（两个 csv 的大小与修改时间），启动时只在基准一致时重放；
+// 每条记录为（载荷长度, 校验和, 载荷），末尾不完整或校验失败的记录在重放时被丢弃。
+// 追加的记录先进入内存缓冲，由后台线程定期批量写入并 fsync（组提交），commit() 可立即落盘；
+// 上次 commit 之后的记录可由 rollback() 丢弃
+class Journal {
+public:
+    enum Op : uint8_t {
+        BORROW = 1,		// 用户编号, 图书编号
+        RETURN,			// 用户编号, 图书编号
+        ADD_BOOK,		// 名称, 编号, 数量
+        ADD_USER,		// 用户名, 密码, 编号, 类型
+        DEL_BOOK,		// 编号, 是否强制
+        DEL_USER,		// 编号, 是否强制
+        MODIFY_BOOK,	// 原编号, 名称, 编号, 数量
+        MODIFY_USER		// 原编号, 用户名, 密码, 编号, 类型
+    };
+
+    // 日志记录的构造
+    class Record {
+    public:
+        explicit Record(Op op) {
+            data.push_back((char)op);
+        }
+
+        Record &put(int32_t value) {
+            data.append((const char *)&value, sizeof(value));
+            return *this;
+        }
+
+        Record &put(const std::string &value) {
+            put((int32_t)value.size());
+            data.append(value);
+            return *this;
+        }
+
+        const std::string &bytes() const {
+            return data;
+        }
+
+    private:
+        std::string data;
+    };
+
+    // 日志记录的读取，越界时返回 false
+    class Reader {
+    public:
+        Reader(const char *data, size_t size): type((Op)(unsigned char)data[0]), cur(data + 1), end(data + size) {}
+
+        Op op() const {
+            return type;
+        }
+
+        bool get(int32_t &value) {
+            if ((size_t)(end - cur) < sizeof(value)) return false;
+            memcpy(&value, cur, sizeof(value));
+            cur += sizeof(value);
+            return true;
+        }
+
+        bool get(std::string &value) {
+            int32_t length;
+            if (!get(length) || length < 0 || (size_t)(end - cur) < (size_t)length) return false;
+            value.assign(cur, length);
+            cur += length;
+            return true;
+        }
+
+    private:
+        Op type;
+        const char *cur;
+        const char *end;
+    };
+
+    Journal(): fd(-1), fileSize(0), committed(0), stopping(false) {}
+
+    ~Journal() {
+        close();
+    }
+
+    Journal(const Journal &) = delete;
+    Journal &operator =(const Journal &) = delete;
+
+    // 重放日志：基准与给定的文件状态一致时，依次对每条完整记录调用 apply
+    // 返回有效内容的长度，日志不存在或基准不一致时返回 0
+    static uint64_t replay(const char *fileName, const snapshot::FileStamp &userStamp,
+                           const snapshot::FileStamp &bookStamp, const std::function<void(Reader &)> &apply) {
+        MappedFile file;
+        if (!file.open(fileName) || file.size() < sizeof(Header)) return 0;
+        Header header;
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, MAGIC, sizeof(header.magic)) || header.version != VERSION
+                || !(header.userFile == userStamp) || !(header.bookFile == bookStamp)) {
+            return 0;
+        }
+        uint64_t pos = sizeof(header);
+        while (file.size() - pos >= 2 * sizeof(uint32_t)) {
+            uint32_t length, sum;
+            memcpy(&length, file.data() + pos, sizeof(length));
+            memcpy(&sum, file.data() + pos + sizeof(length), sizeof(sum));
+            const char *payload = file.data() + pos + 2 * sizeof(uint32_t);
+            if (length == 0 || file.size() - pos - 2 * sizeof(uint32_t) < length
+                    || checksum(payload, length) != sum) {
+                break;
+            }
+            Reader reader(payload, length);
+            apply(reader);
+            pos += 2 * sizeof(uint32_t) + length;
+        }
+        return pos;
+    }
+    // 打开日志以追加；validSize 为 replay 的返回值，其后的残缺内容会被截掉，
+    // 为 0 时新建日志并写入以给定文件状态为基准的文件头
+    bool open(const char *fileName, const snapshot::FileStamp &userStamp,
+              const snapshot::FileStamp &bookStamp, uint64_t validSize) {
+        close();
+        path = fileName;
+        fd = openFile(path, false);
+        if (fd < 0) return false;
+        if (validSize >= sizeof(Header)) {
+            truncateTo(validSize);
+        } else {
+            truncateTo(0);
+            if (!writeHeader(userStamp, bookStamp)) {
+                close();
+                return false;
+            }
+        }
+        committed = fileSize.load();
+        stopping = false;
+        flusher = std::thread(&Journal::flushLoop, this);
+        return true;
+    }
+    // 追加一条记录，日志未打开时忽略
+    void append(const Record &record) {
+        if (fd < 0) return;
+        const std::string &payload = record.bytes();
+        uint32_t length = (uint32_t)payload.size();
+        uint32_t sum = checksum(payload.data(), payload.size());
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        pending.append((const char *)&length, sizeof(length));
+        pending.append((const char *)&sum, sizeof(sum));
+        pending.append(payload);
+        if (pending.size() >= FLUSH_BYTES) wake.notify_one();
+    }
+    // 立即写入全部已追加的记录并落盘
+    bool commit() {
+        if (fd < 0) return false;
+        std::lock_guard<std::mutex> io(ioMutex);
+        if (!flush()) return false;
+        committed = fileSize.load();
+        return true;
+    }
+    // 写入全部已追加的记录，返回此时日志的长度，供 rebase 使用
+    uint64_t mark() {
+        if (fd < 0) return 0;
+        std::lock_guard<std::mutex> io(ioMutex);
+        flush();
+        return fileSize;
+    }
+    // 以新的文件状态为基准重写日志，只保留 mark 之后追加的记录（完整保存进行期间的改动）
+    // 新内容先写入同目录下的临时文件（日志文件名加 .tmp）并落盘，再以重命名整体替换日志，
+    // 中途失败或崩溃时原日志保持完整
+    bool rebase(const snapshot::FileStamp &userStamp, const snapshot::FileStamp &bookStamp, uint64_t mark) {
+        if (fd < 0) return false;
+        std::lock_guard<std::mutex> io(ioMutex);
+        flush();
+        if (mark < sizeof(Header) || mark > fileSize) mark = fileSize;
+        std::string tail(fileSize - mark, '\0');
+        if (!readAt(mark, &tail[0], tail.size())) return false;
+        uint64_t keep = committed > mark ? committed - mark : 0;
+        std::string temp = path + ".tmp";
+        int oldFd = fd;
+        uint64_t oldSize = fileSize;
+        fd = openFile(temp, true);
+        fileSize = 0;
+        bool ok = fd >= 0 && writeHeader(userStamp, bookStamp) && writeAll(tail.data(), tail.size()) && sync();
+        std::error_code ec;
+        if (ok) {
+            uint64_t newSize = fileSize;
+#ifdef _WIN32
+            // 不能替换仍打开的文件，关闭两者后重命名，再重新打开日志
+            closeFile(fd);
+            closeFile(oldFd);
+            std::filesystem::rename(temp, path, ec);
+            fd = openFile(path, false);
+            fileSize = ec ? oldSize : newSize;
+            if (fd >= 0) _lseeki64(fd, (__int64)fileSize, SEEK_SET);
+#else
+            std::filesystem::rename(temp, path, ec);
+            if (ec) std::swap(fd, oldFd);
+            closeFile(oldFd);
+            fileSize = ec ? oldSize : newSize;
+#endif
+            if (!ec) {
+                committed = sizeof(Header) + keep;
+                return true;
+            }
+        } else {
+            if (fd >= 0) closeFile(fd);
+            fd = oldFd;
+            fileSize = oldSize;
+        }
+        remove(temp.c_str());
+        return false;
+    }
+    // 是否所有追加的记录都已 commit
+    bool isCommitted() {
+        if (fd < 0) return true;
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        return pending.empty() && committed == fileSize;
+    }
+    // 丢弃上次 commit 之后追加的记录，退出且不保存时调用
+    void rollback() {
+        if (fd < 0) return;
+        std::lock_guard<std::mutex> io(ioMutex);
+        {
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            pending.clear();
+        }
+        truncateTo(committed);
+        sync();
+    }
+
+    void close() {
+        if (flusher.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(bufferMutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            flusher.join();
+        }
+        if (fd < 0) return;
+        flush();	// 写入线程已退出，无需加锁
+        closeFile(fd);
+        fd = -1;
+        fileSize = 0;
+    }
+
+    // 日志文件路径：与图书文件同目录同名，扩展名为 .lbj
+    static std::string pathFor(const char *bookFile) {
+        return std::filesystem::path(bookFile).replace_extension(".lbj").string();
+    }
+
+    bool isOpen() const {
+        return fd >= 0;
+    }
+    // 日志文件当前大小（字节），用于判断是否需要压实
+    uint64_t size() const {
+        return fileSize;
+    }
+
+private:
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        snapshot::FileStamp userFile;
+        snapshot::FileStamp bookFile;
+    };
+
+    static constexpr char MAGIC[4] = {'L', 'B', 'J', '1'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t FLUSH_BYTES = 1 << 16;	// 缓冲超过该大小时立即唤醒写入线程
+    static constexpr int FLUSH_MS = 20;			// 组提交的最长等待时间
+
+    std::string path;					// 日志文件路径
+    int fd;
+    std::atomic<uint64_t> fileSize;		// 已写入文件的字节数，写入线程与主线程都会访问
+    std::atomic<uint64_t> committed;	// 上次 commit 时的文件大小，isCommitted 不持有 ioMutex 也会读取
+    bool stopping;
+    std::string pending;				// 尚未写入的记录
+    std::mutex bufferMutex;				// 保护 pending 与 stopping
+    std::mutex ioMutex;					// 串行化文件写入
+    std::condition_variable wake;
+    std::thread flusher;
+
+    static uint32_t checksum(const char *data, size_t size) {
+        uint32_t h = 2166136261U;
+        for (size_t i = 0; i < size; i++) {
+            h ^= (unsigned char)data[i];
+            h *= 16777619U;
+        }
+        return h;
+    }
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> lock(bufferMutex);
+        while (!stopping) {
+            wake.wait_for(lock, std::chrono::milliseconds(FLUSH_MS));
+            if (pending.empty()) continue;
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> io(ioMutex);
+                flush();
+            }
+            lock.lock();
+        }
+    }
+    // 把缓冲中的记录一次写入并 fsync，多次 append 共用一次落盘；调用者须持有 ioMutex
+    bool flush() {
+        std::string batch;
+        {
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            batch.swap(pending);
+        }
+        if (batch.empty()) return true;
+        bool ok = writeAll(batch.data(), batch.size());
+        return sync() && ok;
+    }
+
+    // 以读写方式打开文件，不存在时新建；truncate 为 true 时清空原有内容
+    static int openFile(const std::string &fileName, bool truncate) {
+#ifdef _WIN32
+        return _open(fileName.c_str(), _O_RDWR | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : 0),
+                     _S_IREAD | _S_IWRITE);
+#else
+        return ::open(fileName.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+#endif
+    }
+
+    static void closeFile(int fd) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+
+    bool writeHeader(const snapshot::FileStamp &userStamp, const snapshot::FileStamp &bookStamp) {
+        Header header = {};
+        memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.userFile = userStamp;
+        header.bookFile = bookStamp;
+        bool ok = writeAll((const char *)&header, sizeof(header));
+        return sync() && ok;
+    }
+
+    bool writeAll(const char *data, size_t size) {
+        while (size) {
+#ifdef _WIN32
+            int n = _write(fd, data, (unsigned)size);
+#else
+            ssize_t n = ::write(fd, data, size);
+#endif
+            if (n <= 0) return false;
+            data += n;
+            size -= n;
+            fileSize += n;
+        }
+        return true;
+    }
+
+    bool readAt(uint64_t offset, char *data, size_t size) {
+        while (size) {
+#ifdef _WIN32
+            _lseeki64(fd, (__int64)offset, SEEK_SET);
+            int n = _read(fd, data, (unsigned)size);
+#else
+            ssize_t n = pread(fd, data, size, (off_t)offset);
+#endif
+            if (n <= 0) return false;
+            data += n;
+            size -= n;
+            offset += n;
+        }
+#ifdef _WIN32
+        _lseeki64(fd, (__int64)fileSize, SEEK_SET);
+#endif
+        return true;
+    }
+
+    bool sync() {
+#ifdef _WIN32
+        return _commit(fd) == 0;
+#else
+        return fsync(fd) == 0;
+#endif
+    }
+
+    void truncateTo(uint64_t size) {
+#ifdef _WIN32
+        _chsize_s(fd, (__int64)size);
+        _lseeki64(fd, (__int64)size, SEEK_SET);
+#else
+        if (ftruncate(fd, (off_t)size) == 0) lseek(fd, (off_t)size, SEEK_SET);
+#endif
+        fileSize = size;
+    }
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,929 @@
+#include "librarydata.h"
+
+// 读写与查找的耗时统计；按编号、名称的查找只需几十纳秒，计时本身的开销相当，不做统计
+namespace {
+
+profiler::Metric readMetric("Library::read");
+profiler::Metric parseMetric("Library::read/parse");
+profiler::Metric linkMetric("Library::read/link");
+profiler::Metric writeMetric("Library::write");
+profiler::Metric writeBookMetric("Library::writeBook");
+profiler::Metric writeUserMetric("Library::writeUser");
+profiler::Metric findBooksMetric("Library::fuzzyFindBook");
+profiler::Metric findUsersMetric("Library::fuzzyFindUser");
+profiler::Metric pageBooksMetric("Library::fuzzyFindBook/page");
+profiler::Metric pageUsersMetric("Library::fuzzyFindUser/page");
+profiler::Counter loadedCounter("Library::read/rows");
+profiler::Counter danglingCounter("Library::read/danglingIDs");
+profiler::Counter foundCounter("Library::fuzzyFind/results");
+
+}
+
+int Library::read(const char *userFile, const char *bookFile) {
+    profiler::ScopedTimer timer(readMetric);
+    auto lock = writeLock();
+    bool fresh = books.isEmpty() && users.isEmpty();
+    generation++;
+    journal.close();
+    setPaths(userFile, bookFile);
+    int state = loadData(userPath, bookPath);
+    notify(&LibraryListener::reloaded);
+    if (state) return 1;
+    snapshot::stamp(bookPath, bookFileStamp);
+    snapshot::stamp(userPath, userFileStamp);
+    bookFileDivide = userFileDivide = DIVIDE_CHAR;
+    if (fresh) {
+        // 链接时补全或丢弃了借阅编号的行与文件内容不一致
+        booksChanged = hasTouched(books);
+        usersChanged = hasTouched(users);
+        openJournal(true);
+    } else {
+        // 此前已有的记录不在新的数据文件中
+        for (auto *p = books.begin(); p != books.end(); p = p->next) touch(p);
+        for (auto *p = users.begin(); p != users.end(); p = p->next) touch(p);
+    }
+    return 0;
+}
+
+int Library::write(const char *userFile, const char *bookFile) {
+    profiler::ScopedTimer timer(writeMetric);
+    auto job = prepareSave(userFile, bookFile);
+    job->run();
+    return finishSave(*job);
+}
+
+int Library::save() {
+    string user, book;
+    {
+        // 日志只在写锁下打开与关闭，持有读锁即可提交；完整写入前先释放，prepareSave 可能要取写锁
+        auto lock = readLock();
+        if (!needsRewrite()) {
+            if (journal.commit()) return 0;
+            cerr << "[警告] 日志写入失败，改为完整写入数据文件。" << endl;
+        }
+        // 释放锁后并发的 read 可能改变路径，userPath/bookPath 随之失效，先复制
+        user = userFileName;
+        book = bookFileName;
+    }
+    return write(user.c_str(), book.c_str());
+}
+
+int Library::writeBook(const char *bookFile) {
+    profiler::ScopedTimer timer(writeBookMetric);
+    SaveJob job;
+    {
+        auto lock = writeLock();
+        job.divide = DIVIDE_CHAR;
+        job.generation = generation;
+        prepareFile(job.book, bookFile, bookFileName, books, booksChanged, bookFileStamp, bookFileDivide);
+    }
+    job.run();
+    return finishSave(job);
+}
+
+int Library::writeUser(const char *userFile) {
+    profiler::ScopedTimer timer(writeUserMetric);
+    SaveJob job;
+    {
+        auto lock = writeLock();
+        job.divide = DIVIDE_CHAR;
+        job.generation = generation;
+        prepareFile(job.user, userFile, userFileName, users, usersChanged, userFileStamp, userFileDivide);
+    }
+    job.run();
+    return finishSave(job);
+}
+
+std::unique_ptr<SaveJob> Library::prepareSave(const char *userFile, const char *bookFile) {
+    std::shared_lock<RWLock> shared(dataLock);
+    std::unique_lock<RWLock> exclusive(dataLock, std::defer_lock);
+    if (bookFileName == bookFile || userFileName == userFile) {
+        shared.unlock();
+        exclusive.lock();
+    }
+    auto job = std::make_unique<SaveJob>();
+    job->divide = DIVIDE_CHAR;
+    job->generation = generation;
+    // 快照须与写出的 csv 内容一致，在标记待保存的行之前生成；数据与快照都没有变化时不必重写
+    bool current = bookFileName == bookFile && userFileName == userFile;
+    bool unchanged = current && !booksChanged && !usersChanged
+            && bookFileDivide == DIVIDE_CHAR && userFileDivide == DIVIDE_CHAR
+            && isUnchanged(bookFile, bookFileStamp) && isUnchanged(userFile, userFileStamp);
+    if (!(unchanged && snapshot::matches(snapshot::pathFor(bookFile), userFileStamp, bookFileStamp, DIVIDE_CHAR))) {
+        job->writesSnapshot = true;
+        buildSnapshot(job->tables, current);
+    }
+    prepareFile(job->book, bookFile, bookFileName, books, booksChanged, bookFileStamp, bookFileDivide);
+    prepareFile(job->user, userFile, userFileName, users, usersChanged, userFileStamp, userFileDivide);
+    if (job->book.current && job->user.current) {
+        job->journalMark = journal.isOpen() ? journal.mark() : 0;
+    }
+    return job;
+}
+
+int Library::finishSave(SaveJob &job) {
+    auto lock = writeLock();
+    bool same = job.generation == generation;
+    finishFile(job.book, books, booksChanged, bookFileStamp, bookFileDivide, job.divide, same);
+    finishFile(job.user, users, usersChanged, userFileStamp, userFileDivide, job.divide, same);
+    if (job.book.state) {
+        cerr << "无法写入文件。请检查文件\"" << job.book.fileName << "\"是否被占用。" << endl;
+    }
+    if (job.user.state) {
+        cerr << "无法写入文件。请检查文件\"" << job.user.fileName << "\"是否被占用。" << endl;
+    }
+    if (job.book.state || job.user.state) return 1;
+    if (job.writesSnapshot && job.snapshotState) {
+        cerr << "[警告] 快照写入失败，下次启动将读取 csv 文件。" << endl;
+    }
+    if (same && job.book.current && job.user.current) {
+        if (journal.isOpen()) {
+            if (!journal.rebase(userFileStamp, bookFileStamp, job.journalMark)) {
+                cerr << "[警告] 日志重写失败。" << endl;
+            }
+        } else if (!booksChanged && !usersChanged) {
+            // 日志未打开期间的改动不在日志中，有新改动时仍要等下次完整保存
+            openJournal(false);
+        }
+    }
+    return 0;
+}
+
+List<Node<BookInfo>*> Library::fuzzyFindBook(const string &name) {
+    profiler::ScopedTimer timer(findBooksMetric);
+    auto lock = readLock();
+    List<Node<BookInfo>*> ret;
+    std::vector<Node<BookInfo>*> found;
+    if (bookGrams.search(name, nameOf<BookInfo>, found)) {
+        for (auto *p : found) ret.append(p);
+        foundCounter.add(ret.size());
+        return ret;
+    }
+    for (auto *p = books.begin(); p != books.end(); p = p->next) {
+        if (p->elem.name.find(name) != string::npos) {
+            ret.append(p);
+        }
+    }
+    foundCounter.add(ret.size());
+    return ret;
+}
+
+List<Node<UserInfo>*> Library::fuzzyFindUser(const string &name) {
+    profiler::ScopedTimer timer(findUsersMetric);
+    auto lock = readLock();
+    List<Node<UserInfo>*> ret;
+    std::vector<Node<UserInfo>*> found;
+    if (userGrams.search(name, nameOf<UserInfo>, found)) {
+        for (auto *p : found) ret.append(p);
+        foundCounter.add(ret.size());
+        return ret;
+    }
+    for (auto *p = users.begin(); p != users.end(); p = p->next) {
+        if (p->elem.name.find(name) != string::npos) {
+            ret.append(p);
+        }
+    }
+    foundCounter.add(ret.size());
+    return ret;
+}
+
+Node<BookInfo>* Library::fuzzyFindBook(const string &name, Node<BookInfo> *from, bool forward, size_t limit,
+                                       std::vector<Node<BookInfo>*> &out, size_t budget) {
+    profiler::ScopedTimer timer(pageBooksMetric);
+    auto lock = readLock();
+    Node<BookInfo> *resume;
+    size_t before = out.size();
+    if (!bookGrams.searchPage(name, nameOf<BookInfo>, from, forward, limit, out, budget, &resume)) {
+        resume = scanPage(books, name, from, forward, limit, out, budget);
+    }
+    foundCounter.add(out.size() - before);
+    return resume;
+}
+
+Node<UserInfo>* Library::fuzzyFindUser(const string &name, Node<UserInfo> *from, bool forward, size_t limit,
+                                       std::vector<Node<UserInfo>*> &out, size_t budget) {
+    profiler::ScopedTimer timer(pageUsersMetric);
+    auto lock = readLock();
+    Node<UserInfo> *resume;
+    size_t before = out.size();
+    if (!userGrams.searchPage(name, nameOf<UserInfo>, from, forward, limit, out, budget, &resume)) {
+        resume = scanPage(users, name, from, forward, limit, out, budget);
+    }
+    foundCounter.add(out.size() - before);
+    return resume;
+}
+
+Node<BookInfo>* Library::add(BookInfo book) {
+    auto lock = writeLock();
+    Node<BookInfo> *ret = load(std::move(book));
+    if (ret) {
+        touch(ret);
+        journal.append(Journal::Record(Journal::ADD_BOOK).put(ret->elem.name)
+                       .put(ret->elem.identifier).put(ret->elem.quantity));
+        notify(&LibraryListener::bookAdded, ret);
+    }
+    return ret;
+}
+
+Node<UserInfo>* Library::add(UserInfo user) {
+    auto lock = writeLock();
+    Node<UserInfo> *ret = load(std::move(user));
+    if (ret) {
+        touch(ret);
+        journal.append(Journal::Record(Journal::ADD_USER).put(ret->elem.name).put(ret->elem.password)
+                       .put(ret->elem.identifier).put(ret->elem.type));
+        notify(&LibraryListener::userAdded, ret);
+    }
+    return ret;
+}
+
+Node<BookInfo>* Library::del(Node<BookInfo>* book, bool force) {
+    auto lock = writeLock();
+    if (book == nullptr) {
+        cerr << "不存在符合条件的图书。" << endl;
+        return nullptr;
+    }
+    auto &readers = book->elem.readers;
+    if (!readers.isEmpty()) {
+        cerr << "[警告] 现在还有 " << readers.size() << " 名用户未还该书 《"
+             << book->elem.name << "》(" << book->elem.identifier << ")。" << endl;
+        if (!force) return nullptr;
+    }
+    journal.append(Journal::Record(Journal::DEL_BOOK).put(book->elem.identifier).put((int)force));
+    while (!book->elem.readers.isEmpty()) {
+        unlinkLoan(book->elem.readers.begin()->elem.peer);
+    }
+    booksChanged = true;
+    notify(&LibraryListener::bookRemoved, book);
+    removedCount++;
+    unindexBook(book);
+    bookGrams.release(book);
+    return books.del(book);
+}
+
+Node<UserInfo>* Library::del(Node<UserInfo>* user, bool force) {
+    auto lock = writeLock();
+    if (user == nullptr) {
+        cerr << "不存在符合条件的用户。" << endl;
+        return nullptr;
+    }
+    auto &books = user->elem.books;
+    if (!books.isEmpty()) {
+        cerr << "[警告] 该用户" << user->elem.name << "(" << user->elem.identifier
+             << ") " << "未还图书 " << books.size() << " 本。";
+        if (!force) return nullptr;
+    }
+    journal.append(Journal::Record(Journal::DEL_USER).put(user->elem.identifier).put((int)force));
+    while (!user->elem.books.isEmpty()) {
+        unlinkLoan(user->elem.books.begin());
+    }
+    usersChanged = true;
+    notify(&LibraryListener::userRemoved, user);
+    removedCount++;
+    unindexUser(user);
+    userGrams.release(user);
+    return users.del(user);
+}
+
+Node<BookInfo>* Library::modify(Node<BookInfo>* src, BookInfo target) {
+    auto lock = writeLock();
+    if (src == nullptr || src == books.end()) {
+        return books.modify(src, std::move(target));
+    }
+    // 借阅记录与加入次序随节点保留，不被 target 覆盖
+    target.readers = std::move(src->elem.readers);
+    target.serial = src->elem.serial;
+    int oldID = src->elem.identifier;
+    if (src->elem.identifier == target.identifier && src->elem.name == target.name) {
+        books.modify(src, std::move(target));
+    } else {
+        unindexBook(src);
+        books.modify(src, std::move(target));
+        indexBook(src);
+    }
+    modified(oldID, src);
+    return src;
+}
+
+Node<UserInfo>* Library::modify(Node<UserInfo>* src, UserInfo target) {
+    auto lock = writeLock();
+    if (src == nullptr || src == users.end()) {
+        return users.modify(src, std::move(target));
+    }
+    // 借阅记录与加入次序随节点保留，不被 target 覆盖
+    target.books = std::move(src->elem.books);
+    target.serial = src->elem.serial;
+    int oldID = src->elem.identifier;
+    if (src->elem.identifier == target.identifier && src->elem.name == target.name) {
+        users.modify(src, std::move(target));
+    } else {
+        unindexUser(src);
+        users.modify(src, std::move(target));
+        indexUser(src);
+    }
+    modified(oldID, src);
+    return src;
+}
+
+Node<BookInfo>* Library::modifyID(Node<BookInfo>* book, int id) {
+    auto lock = writeLock();
+    if (book == nullptr) return nullptr;
+    if (book->elem.identifier == id) return book;
+    int oldID = book->elem.identifier;
+    unindexKey(bookIndex, bookIDDups, &BookInfo::identifier, book);
+    book->elem.identifier = id;
+    indexKey(bookIndex, bookIDDups, &BookInfo::identifier, book);
+    modified(oldID, book);
+    return book;
+}
+
+Node<BookInfo>* Library::modifyName(Node<BookInfo>* book, string name) {
+    auto lock = writeLock();
+    if (book == nullptr) return nullptr;
+    if (book->elem.name == name) return book;
+    unindexKey(bookNameIndex, bookNameDups, &BookInfo::name, book);
+    bookGrams.erase(book->elem.name, book);
+    book->elem.name = name;
+    indexKey(bookNameIndex, bookNameDups, &BookInfo::name, book);
+    bookGrams.insert(book->elem.name, book);
+    modified(book->elem.identifier, book);
+    return book;
+}
+
+Node<BookInfo>* Library::setQuantity(Node<BookInfo>* book, int quantity) {
+    auto lock = writeLock();
+    if (book == nullptr) return nullptr;
+    if (book->elem.quantity == quantity) return book;
+    book->elem.quantity = quantity;
+    modified(book->elem.identifier, book);
+    return book;
+}
+
+Node<UserInfo>* Library::modifyID(Node<UserInfo>* user, int id) {
+    auto lock = writeLock();
+    if (user == nullptr) return nullptr;
+    if (user->elem.identifier == id) return user;
+    int oldID = user->elem.identifier;
+    unindexKey(userIndex, userIDDups, &UserInfo::identifier, user);
+    user->elem.identifier = id;
+    indexKey(userIndex, userIDDups, &UserInfo::identifier, user);
+    modified(oldID, user);
+    return user;
+}
+
+Node<UserInfo>* Library::modifyName(Node<UserInfo>* user, string name) {
+    auto lock = writeLock();
+    if (user == nullptr) return nullptr;
+    if (user->elem.name == name) return user;
+    unindexKey(userNameIndex, userNameDups, &UserInfo::name, user);
+    userGrams.erase(user->elem.name, user);
+    user->elem.name = name;
+    indexKey(userNameIndex, userNameDups, &UserInfo::name, user);
+    userGrams.insert(user->elem.name, user);
+    modified(user->elem.identifier, user);
+    return user;
+}
+
+Node<UserInfo>* Library::setPassword(Node<UserInfo>* user, string password) {
+    auto lock = writeLock();
+    if (user == nullptr) return nullptr;
+    if (user->elem.password == password) return user;
+    user->elem.password = std::move(password);
+    modified(user->elem.identifier, user);
+    return user;
+}
+
+Node<UserInfo>* Library::setType(Node<UserInfo>* user, int type) {
+    auto lock = writeLock();
+    if (user == nullptr) return nullptr;
+    if (user->elem.type == type) return user;
+    user->elem.type = type;
+    modified(user->elem.identifier, user);
+    return user;
+}
+
+int Library::borrowBook(Node<UserInfo>* userNode, Node<BookInfo>* bookNode) {
+    auto lock = writeLock();
+    if (!userNode || !bookNode) {
+        cerr << "不存在符合条件的图书或用户。" << endl;
+        return 1;
+    }
+    const BookInfo &book = bookNode->elem;
+    // 判断书是否还有剩余
+    int quantity = book.quantity;
+    if (quantity <= book.readers.size()) {
+        cerr << "[信息] 该书 《" << book.name << "》(" << book.identifier << ") 已经被借完了。" << endl;
+        return 1;
+    }
+    auto retBook = bookNode->elem.readers.append(ReaderLoan(userNode, nullptr));
+    if (!retBook) return 1;
+    if (!pairLoan(userNode, bookNode, retBook)) {
+        bookNode->elem.readers.del(retBook);
+        return 1;
+    }
+    touch(userNode);
+    touch(bookNode);
+    journal.append(Journal::Record(Journal::BORROW).put(userNode->elem.identifier).put(book.identifier));
+    notify(&LibraryListener::loanAdded, userNode, bookNode);
+    return 0;
+}
+
+int Library::returnBook(Node<UserInfo>* userNode, Node<BookInfo>* bookNode) {
+    auto lock = writeLock();
+    if (!userNode || !bookNode) {
+        cerr << "不存在符合条件的图书或用户。" << endl;
+        return 1;
+    }
+    auto *list = loans.get(LoanKey(userNode, bookNode));
+    if (!list || list->empty()) return 1;
+    unlinkLoan(list->front());
+    journal.append(Journal::Record(Journal::RETURN).put(userNode->elem.identifier)
+                   .put(bookNode->elem.identifier));
+    return 0;
+}
+
+bool Library::hasBorrowed(Node<UserInfo>* userNode, Node<BookInfo>* bookNode) {
+    auto lock = readLock();
+    if (!userNode || !bookNode) return false;
+    auto *list = loans.get(LoanKey(userNode, bookNode));
+    return list && !list->empty();
+}
+
+int Library::checkLoans() {
+    auto lock = readLock();
+    int problems = 0;
+    size_t readerCount = 0, loanCount = 0;
+    for (auto *p = books.begin(); p != books.end(); p = p->next) {
+        if (p->elem.readers.size() > p->elem.quantity) problems++;
+        for (auto *q = p->elem.readers.begin(); q != p->elem.readers.end(); q = q->next) {
+            Node<BookLoan> *loan = q->elem.peer;
+            if (!loan || loan->elem.book != p || loan->elem.peer != q) problems++;
+            readerCount++;
+        }
+    }
+    for (auto *p = users.begin(); p != users.end(); p = p->next) {
+        for (auto *q = p->elem.books.begin(); q != p->elem.books.end(); q = q->next) {
+            Node<ReaderLoan> *reader = q->elem.peer;
+            if (!reader || reader->elem.user != p || reader->elem.peer != q) problems++;
+            auto *list = q->elem.book ? loans.get(LoanKey(p, q->elem.book)) : nullptr;
+            if (!list || std::find(list->begin(), list->end(), q) == list->end()) problems++;
+            loanCount++;
+        }
+    }
+    if (readerCount != loanCount) problems++;
+    return problems;
+}
+
+Node<UserInfo>* Library::login(string userName, string password) {
+    auto lock = readLock();
+    auto result = findUser(userName);
+    if (result && result->elem.password == password) {
+        return result;
+    }
+    return nullptr;
+}
+
+void Library::setPaths(const char *userFile, const char *bookFile) {
+    string user(userFile), book(bookFile);	// 参数可能正指向当前路径，先复制
+    userFileName = std::move(user);
+    bookFileName = std::move(book);
+    userPath = userFileName.c_str();
+    bookPath = bookFileName.c_str();
+}
+
+int Library::openJournal(bool replay) {
+    snapshot::FileStamp userStamp, bookStamp;
+    journal.close();
+    if (!snapshot::stamp(userPath, userStamp) || !snapshot::stamp(bookPath, bookStamp)) return 1;
+    string fileName = Journal::pathFor(bookPath);
+    uint64_t validSize = 0;
+    if (replay) {
+        int count = 0, failed = 0;
+        validSize = Journal::replay(fileName.c_str(), userStamp, bookStamp, [&](Journal::Reader &record) {
+            if (replayRecord(record)) failed++;
+            else count++;
+        });
+        if (count) cerr << "[信息] 已从日志恢复 " << count << " 项改动。" << endl;
+        if (failed) cerr << "[警告] 日志中有 " << failed << " 项改动无法重放，已忽略。" << endl;
+    }
+    if (!journal.open(fileName.c_str(), userStamp, bookStamp, validSize)) {
+        cerr << "[警告] 无法打开日志文件\"" << fileName << "\"，保存时将完整写入数据文件。" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Library::replayRecord(Journal::Reader &record) {
+    int32_t a, b, c;
+    string name, password;
+    switch (record.op()) {
+    case Journal::BORROW:
+        if (!record.get(a) || !record.get(b)) return 1;
+        return borrowBook(findUser(a), findBook(b));
+    case Journal::RETURN:
+        if (!record.get(a) || !record.get(b)) return 1;
+        return returnBook(findUser(a), findBook(b));
+    case Journal::ADD_BOOK:
+        if (!record.get(name) || !record.get(a) || !record.get(b)) return 1;
+        return add(BookInfo(name, a, b)) ? 0 : 1;
+    case Journal::ADD_USER:
+        if (!record.get(name) || !record.get(password) || !record.get(a) || !record.get(b)) return 1;
+        return add(UserInfo(name, password, a, b)) ? 0 : 1;
+    case Journal::DEL_BOOK:
+        if (!record.get(a) || !record.get(b) || !findBook(a)) return 1;
+        del(findBook(a), b != 0);
+        return 0;
+    case Journal::DEL_USER:
+        if (!record.get(a) || !record.get(b) || !findUser(a)) return 1;
+        del(findUser(a), b != 0);
+        return 0;
+    case Journal::MODIFY_BOOK:
+        if (!record.get(a) || !record.get(name) || !record.get(b) || !record.get(c)) return 1;
+        return modify(findBook(a), BookInfo(name, b, c)) ? 0 : 1;
+    case Journal::MODIFY_USER:
+        if (!record.get(a) || !record.get(name) || !record.get(password)
+                || !record.get(b) || !record.get(c)) return 1;
+        return modify(findUser(a), UserInfo(name, password, b, c)) ? 0 : 1;
+    }
+    return 1;
+}
+
+void Library::modified(int oldID, Node<BookInfo> *book) {
+    touch(book);
+    if (oldID != book->elem.identifier) {
+        auto &readers = book->elem.readers;
+        for (auto *q = readers.begin(); q != readers.end(); q = q->next) touch(q->elem.user);
+    }
+    journal.append(Journal::Record(Journal::MODIFY_BOOK).put(oldID).put(book->elem.name)
+                   .put(book->elem.identifier).put(book->elem.quantity));
+    notify(&LibraryListener::bookChanged, oldID, book);
+}
+
+void Library::modified(int oldID, Node<UserInfo> *user) {
+    touch(user);
+    if (oldID != user->elem.identifier) {
+        auto &books = user->elem.books;
+        for (auto *q = books.begin(); q != books.end(); q = q->next) touch(q->elem.book);
+    }
+    journal.append(Journal::Record(Journal::MODIFY_USER).put(oldID).put(user->elem.name)
+                   .put(user->elem.password).put(user->elem.identifier).put(user->elem.type));
+    notify(&LibraryListener::userChanged, oldID, user);
+}
+
+int Library::loadData(const char *userFile, const char *bookFile) {
+    // 快照与两个 csv 文件一致时直接从快照加载
+    if (!loadSnapshot(userFile, bookFile)) {
+        danglingIDs = 0;
+        return 0;
+    }
+    // 两个文件按行切块，所有块在线程池中并行解析，再按原顺序依次加入链表
+    MappedFile userData, bookData;
+    int userState = openDataFile(userData, userFile);
+    int bookState = openDataFile(bookData, bookFile);
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<CsvChunk> userChunks = splitChunks(userData.view(), threads);
+    std::vector<CsvChunk> bookChunks = splitChunks(bookData.view(), threads);
+    Node<UserInfo> *lastUser = users.end()->prev;
+    Node<BookInfo> *lastBook = books.end()->prev;
+    {
+        // 解析与加入链表（含建立索引）
+        profiler::ScopedTimer timer(parseMetric);
+        std::vector<std::function<void()>> tasks;
+        for (auto &chunk : userChunks) {
+            tasks.push_back([&chunk, this]() { chunk.parse(DIVIDE_CHAR, 2); });
+        }
+        for (auto &chunk : bookChunks) {
+            tasks.push_back([&chunk, this]() { chunk.parse(DIVIDE_CHAR, 1); });
+        }
+        runParallel(tasks);
+        if (userDataReader(userChunks, userData.data()) || bookDataReader(bookChunks, bookData.data())) {
+            unload(lastBook, lastUser);
+            cerr << "内存不足，未能读取数据。" << endl;
+            return 1;
+        }
+    }
+    if (userState || bookState) {
+        cerr << "未读取到数据。" << endl;
+        return 1;
+    }
+    for (auto &chunk : userChunks) loadedCounter.add(chunk.records.size());
+    for (auto &chunk : bookChunks) loadedCounter.add(chunk.records.size());
+    {
+        profiler::ScopedTimer timer(linkMetric);
+        danglingIDs = linkLoans(userChunks, lastUser->next, bookChunks, lastBook->next);
+    }
+    danglingCounter.add(danglingIDs);
+    if (danglingIDs) {
+        cerr << "[警告] 有 " << danglingIDs << " 个借阅编号找不到对应的图书或用户，已忽略。" << endl;
+    }
+    return 0;
+}
+
+Node<BookLoan>* Library::pairLoan(Node<UserInfo> *user, Node<BookInfo> *book, Node<ReaderLoan> *reader) {
+    Node<BookLoan> *loan = user->elem.books.append(BookLoan(book, reader));
+    if (!loan) return nullptr;
+    reader->elem.peer = loan;
+    loans.obtain(LoanKey(user, book)).push_back(loan);
+    return loan;
+}
+
+void Library::unlinkLoan(Node<BookLoan> *loan) {
+    Node<BookInfo> *book = loan->elem.book;
+    Node<ReaderLoan> *reader = loan->elem.peer;
+    Node<UserInfo> *user = reader->elem.user;
+    auto *list = loans.get(LoanKey(user, book));
+    for (auto it = list->begin(); it != list->end(); ++it) {
+        if (*it == loan) {
+            list->erase(it);
+            break;
+        }
+    }
+    if (list->empty()) loans.erase(LoanKey(user, book));
+    book->elem.readers.del(reader);
+    user->elem.books.del(loan);
+    touch(book);
+    touch(user);
+    notify(&LibraryListener::loanRemoved, user, book);
+}
+
+void Library::formatLine(string &line, const BookInfo &book) const {
+    line = book.name;
+    appendField(line, std::to_string(book.identifier));
+    appendField(line, std::to_string(book.quantity));
+    for (auto *q = book.readers.begin(); q != book.readers.end(); q = q->next) {
+        Node<UserInfo> *user = q->elem.user;
+        appendField(line, std::to_string(user->elem.identifier));
+    }
+}
+
+void Library::formatLine(string &line, const UserInfo &user) const {
+    line = user.name;
+    appendField(line, user.password);
+    appendField(line, std::to_string(user.identifier));
+    appendField(line, std::to_string(user.type));
+    for (auto *q = user.books.begin(); q != user.books.end(); q = q->next) {
+        Node<BookInfo> *book = q->elem.book;
+        appendField(line, std::to_string(book->elem.identifier));
+    }
+}
+
+void Library::buildSnapshot(snapshot::Tables &tables, bool current) const {
+    string &heap = tables.heap;
+    std::vector<snapshot::BookRecord> &bookRecords = tables.books;
+    std::vector<snapshot::UserRecord> &userRecords = tables.users;
+    std::vector<snapshot::LoanRecord> &loanRecords = tables.loans;
+    std::vector<uint32_t> &readerOrder = tables.readerOrder;
+    HashIndex<Node<BookInfo>*, uint32_t> bookNo;
+    HashIndex<Node<UserInfo>*, uint32_t> userNo;
+    HashIndex<Node<BookLoan>*, uint32_t> loanNo;
+    bookRecords.reserve(books.size());
+    userRecords.reserve(users.size());
+    bookNo.reserve(books.size());
+    userNo.reserve(users.size());
+    for (auto *p = books.begin(); p != books.end(); p = p->next) {
+        bookNo.insert(p, (uint32_t)bookRecords.size());
+        snapshot::BookRecord record = {};
+        record.nameOffset = heap.size();
+        record.nameLength = (uint32_t)p->elem.name.size();
+        record.identifier = p->elem.identifier;
+        record.quantity = p->elem.quantity;
+        if (current) {
+            record.lineOffset = p->elem.lineOffset;
+            record.lineLength = (uint32_t)p->elem.lineLength;
+        }
+        heap += p->elem.name;
+        bookRecords.push_back(record);
+    }
+    for (auto *p = users.begin(); p != users.end(); p = p->next) {
+        uint32_t no = (uint32_t)userRecords.size();
+        userNo.insert(p, no);
+        snapshot::UserRecord record = {};
+        record.nameOffset = heap.size();
+        record.nameLength = (uint32_t)p->elem.name.size();
+        heap += p->elem.name;
+        record.passwordOffset = heap.size();
+        record.passwordLength = (uint32_t)p->elem.password.size();
+        heap += p->elem.password;
+        record.identifier = p->elem.identifier;
+        record.type = p->elem.type;
+        if (current) {
+            record.lineOffset = p->elem.lineOffset;
+            record.lineLength = (uint32_t)p->elem.lineLength;
+        }
+        userRecords.push_back(record);
+        for (auto *q = p->elem.books.begin(); q != p->elem.books.end(); q = q->next) {
+            loanNo.insert(q, (uint32_t)loanRecords.size());
+            loanRecords.push_back(snapshot::LoanRecord{no, bookNo.find(q->elem.book)});
+        }
+    }
+    readerOrder.reserve(loanRecords.size());
+    for (auto *p = books.begin(); p != books.end(); p = p->next) {
+        for (auto *q = p->elem.readers.begin(); q != p->elem.readers.end(); q = q->next) {
+            readerOrder.push_back(loanNo.find(q->elem.peer));
+        }
+    }
+}
+
+int Library::loadSnapshot(const char *userFile, const char *bookFile) {
+    snapshot::FileStamp userStamp, bookStamp;
+    if (!snapshot::stamp(userFile, userStamp) || !snapshot::stamp(bookFile, bookStamp)) return 1;
+    MappedFile file;
+    string fileName = snapshot::pathFor(bookFile);
+    if (!file.open(fileName.c_str()) || file.size() < sizeof(snapshot::Header)) return 1;
+    snapshot::Header header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, snapshot::MAGIC, sizeof(header.magic)) || header.version != snapshot::VERSION
+            || header.byteOrder != snapshot::ENDIAN_MARK || header.headerSize != sizeof(header)
+            || header.divide != (unsigned char)DIVIDE_CHAR
+            || !(header.userFile == userStamp) || !(header.bookFile == bookStamp)) {
+        return 1;
+    }
+    // 校验各表大小与引用范围
+    uint64_t bookCount = header.bookCount, userCount = header.userCount, loanCount = header.loanCount;
+    if (bookCount > UINT32_MAX || userCount > UINT32_MAX || loanCount > UINT32_MAX) return 1;
+    uint64_t size = sizeof(header) + bookCount * sizeof(snapshot::BookRecord)
+            + userCount * sizeof(snapshot::UserRecord) + loanCount * sizeof(snapshot::LoanRecord)
+            + loanCount * sizeof(uint32_t) + header.heapSize;
+    if (size != file.size()) return 1;
+    const char *cursor = file.data() + sizeof(header);
+    auto *bookRecords = (const snapshot::BookRecord *)cursor;
+    cursor += bookCount * sizeof(snapshot::BookRecord);
+    auto *userRecords = (const snapshot::UserRecord *)cursor;
+    cursor += userCount * sizeof(snapshot::UserRecord);
+    auto *loanRecords = (const snapshot::LoanRecord *)cursor;
+    cursor += loanCount * sizeof(snapshot::LoanRecord);
+    auto *readerOrder = (const uint32_t *)cursor;
+    cursor += loanCount * sizeof(uint32_t);
+    const char *heap = cursor;
+    auto inHeap = [&](uint64_t offset, uint64_t length) {
+        return offset <= header.heapSize && length <= header.heapSize - offset;
+    };
+    for (uint64_t i = 0; i < bookCount; i++) {
+        if (!inHeap(bookRecords[i].nameOffset, bookRecords[i].nameLength)) return 1;
+    }
+    for (uint64_t i = 0; i < userCount; i++) {
+        if (!inHeap(userRecords[i].nameOffset, userRecords[i].nameLength)
+                || !inHeap(userRecords[i].passwordOffset, userRecords[i].passwordLength)) return 1;
+    }
+    for (uint64_t i = 0; i < loanCount; i++) {
+        if (loanRecords[i].user >= userCount || loanRecords[i].book >= bookCount) return 1;
+    }
+    std::vector<bool> placed(loanCount);
+    for (uint64_t i = 0; i < loanCount; i++) {
+        if (readerOrder[i] >= loanCount || placed[readerOrder[i]]) return 1;
+        placed[readerOrder[i]] = true;
+    }
+    // 按表重建链表、索引与借阅记录
+    std::vector<Node<BookInfo>*> bookNodes(bookCount);
+    std::vector<Node<UserInfo>*> userNodes(userCount);
+    std::vector<Node<ReaderLoan>*> readerNodes(loanCount);
+    bookIndex.reserve(bookIndex.size() + bookCount);
+    bookNameIndex.reserve(bookNameIndex.size() + bookCount);
+    userIndex.reserve(userIndex.size() + userCount);
+    userNameIndex.reserve(userNameIndex.size() + userCount);
+    Node<BookInfo> *lastBook = books.end()->prev;
+    Node<UserInfo> *lastUser = users.end()->prev;
+    for (uint64_t i = 0; i < bookCount; i++) {
+        const snapshot::BookRecord &r = bookRecords[i];
+        bookNodes[i] = load(BookInfo(string(heap + r.nameOffset, r.nameLength), r.identifier, r.quantity));
+        if (!bookNodes[i]) {
+            unload(lastBook, lastUser);
+            return 1;
+        }
+        bookNodes[i]->elem.lineOffset = r.lineOffset;
+        bookNodes[i]->elem.lineLength = r.lineLength;
+    }
+    for (uint64_t i = 0; i < userCount; i++) {
+        const snapshot::UserRecord &r = userRecords[i];
+        userNodes[i] = load(UserInfo(string(heap + r.nameOffset, r.nameLength),
+                                     string(heap + r.passwordOffset, r.passwordLength), r.identifier, r.type));
+        if (!userNodes[i]) {
+            unload(lastBook, lastUser);
+            return 1;
+        }
+        userNodes[i]->elem.lineOffset = r.lineOffset;
+        userNodes[i]->elem.lineLength = r.lineLength;
+    }
+    for (uint64_t i = 0; i < loanCount; i++) {
+        const snapshot::LoanRecord &r = loanRecords[readerOrder[i]];
+        readerNodes[readerOrder[i]] = bookNodes[r.book]->elem.readers.append(ReaderLoan(userNodes[r.user], nullptr));
+    }
+    for (uint64_t i = 0; i < loanCount; i++) {
+        pairLoan(userNodes[loanRecords[i].user], bookNodes[loanRecords[i].book], readerNodes[i]);
+    }
+    return 0;
+}
+
+int Library::openDataFile(MappedFile &file, const char *fileName) {
+    if (!file.open(fileName)) {
+        cerr << "数据读取失败。请检查文件\"" << fileName << "\"是否存在。" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+void Library::unload(Node<BookInfo> *lastBook, Node<UserInfo> *lastUser) {
+    while (books.end()->prev != lastBook) {
+        Node<BookInfo> *book = books.end()->prev;
+        unindexBook(book);
+        bookGrams.release(book);
+        books.del(book);
+    }
+    while (users.end()->prev != lastUser) {
+        Node<UserInfo> *user = users.end()->prev;
+        unindexUser(user);
+        userGrams.release(user);
+        users.del(user);
+    }
+}
+
+int Library::bookDataReader(const std::vector<CsvChunk> &chunks, const char *base) {
+    size_t count = 0;
+    for (const CsvChunk &chunk : chunks) count += chunk.records.size();
+    bookIndex.reserve(bookIndex.size() + count);
+    bookNameIndex.reserve(bookNameIndex.size() + count);
+    for (const CsvChunk &chunk : chunks) {
+        for (const CsvRecord &record : chunk.records) {
+            Node<BookInfo> *book = load(BookInfo(string(record.text[0]), record.number[0], record.number[1]));
+            if (!book) return 1;
+            book->elem.lineOffset = record.line.data() - base;
+            book->elem.lineLength = record.skipped ? 0 : record.line.size();
+        }
+    }
+    return 0;
+}
+
+int Library::userDataReader(const std::vector<CsvChunk> &chunks, const char *base) {
+    size_t count = 0;
+    for (const CsvChunk &chunk : chunks) count += chunk.records.size();
+    userIndex.reserve(userIndex.size() + count);
+    userNameIndex.reserve(userNameIndex.size() + count);
+    for (const CsvChunk &chunk : chunks) {
+        for (const CsvRecord &record : chunk.records) {
+            Node<UserInfo> *user = load(UserInfo(string(record.text[0]), string(record.text[1]),
+                                                 record.number[0], record.number[1]));
+            if (!user) return 1;
+            user->elem.lineOffset = record.line.data() - base;
+            user->elem.lineLength = record.skipped ? 0 : record.line.size();
+        }
+    }
+    return 0;
+}
+
+int Library::linkLoans(const std::vector<CsvChunk> &userChunks, Node<UserInfo> *firstUser,
+                       const std::vector<CsvChunk> &bookChunks, Node<BookInfo> *firstBook) {
+    int dangling = 0;
+    size_t readerCount = 0;
+    for (const CsvChunk &chunk : bookChunks) readerCount += chunk.ids.size();
+    HashIndex<LoanKey, std::vector<Node<ReaderLoan>*>> pending;
+    pending.reserve(readerCount);
+    Node<BookInfo> *book = firstBook;
+    for (const CsvChunk &chunk : bookChunks) {
+        for (const CsvRecord &record : chunk.records) {
+            for (size_t i = record.idBegin; i < record.idEnd; i++) {
+                Node<UserInfo> *user = findUser(chunk.ids[i]);
+                if (!user) {
+                    dangling++;
+                    touch(book);
+                    continue;
+                }
+                pending.obtain(LoanKey(user, book)).push_back(book->elem.readers.append(ReaderLoan(user, nullptr)));
+            }
+            book = book->next;
+        }
+    }
+    Node<UserInfo> *user = firstUser;
+    for (const CsvChunk &chunk : userChunks) {
+        for (const CsvRecord &record : chunk.records) {
+            for (size_t i = record.idBegin; i < record.idEnd; i++) {
+                Node<BookInfo> *target = findBook(chunk.ids[i]);
+                if (!target) {
+                    dangling++;
+                    touch(user);
+                    continue;
+                }
+                auto *readers = pending.get(LoanKey(user, target));
+                Node<ReaderLoan> *reader;
+                if (readers && !readers->empty()) {
+                    reader = readers->front();
+                    readers->erase(readers->begin());
+                } else {
+                    reader = target->elem.readers.append(ReaderLoan(user, nullptr));
+                    touch(target);
+                }
+                pairLoan(user, target, reader);
+            }
+            user = user->next;
+        }
+    }
+    // 仅出现在图书文件中的借阅记录，补上用户一侧
+    for (book = firstBook; book != books.end(); book = book->next) {
+        for (auto *q = book->elem.readers.begin(); q != book->elem.readers.end(); q = q->next) {
+            if (!q->elem.peer) {
+                pairLoan(q->elem.user, book, q);
+                touch(q->elem.user);
+            }
+        }
+    }
+    return dangling;
+}
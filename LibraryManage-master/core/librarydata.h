@@ -0,0 +1,890 @@
+#ifndef LIBRARYDATA_H
+#define LIBRARYDATA_H
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "csvreader.h"
+#include "hashindex.h"
+#include "journal.h"
+#include "ngramindex.h"
+#include "nodepool.h"
+#include "profiler.h"
+#include "rwlock.h"
+#include "savejob.h"
+#include "snapshot.h"
+
+using std::string;
+using std::ofstream;
+using std::ifstream;
+using std::ostream;
+using std::istream;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+class BookInfo;		// 图书信息类
+class UserInfo;		// 用户类
+
+// 链表节点
+template<class T> struct Node {
+    T elem;			// 链表元素
+    Node<T> *prev;	// 前向指针
+    Node<T> *next;	// 后向指针
+
+    friend ostream &operator <<(ostream &output, const Node &node) {
+        output << node.elem;
+        return output;
+    }
+
+    friend ostream &operator <<(ostream &output, const Node *&node) {
+        output << node->elem;
+        return output;
+    }
+};
+// 链表，Alloc 为节点内存分配策略，需提供静态的 allocate()/deallocate(void*)
+template<class T, class Alloc = NodePool<Node<T>>> class List {
+public:
+    // 初始化链表
+    List(): length(0) {
+        head = newHead();
+    }
+    // 深拷贝：复制全部元素到新链表
+    List(const List &other): length(0) {
+        head = newHead();
+        for (Node<T> *p = other.head->next; p != other.head; p = p->next)
+            append(p->elem);
+    }
+    // 移动：直接接管对方的节点，对方变为空链表
+    List(List &&other): length(other.length) {
+        head = other.head;
+        other.head = newHead();
+        other.length = 0;
+    }
+
+    List &operator =(const List &other) {
+        if (this != &other) {
+            List tmp(other);
+            std::swap(head, tmp.head);
+            std::swap(length, tmp.length);
+        }
+        return *this;
+    }
+
+    List &operator =(List &&other) {
+        std::swap(head, other.head);
+        std::swap(length, other.length);
+        return *this;
+    }
+
+    ~List() {
+        clear();
+        freeNode(head);
+    }
+    // 重载下标运算符，便于访问链表元素
+    T &operator [](int idx) {
+        Node<T> *p = getNode(idx);
+        if (!p) return head->elem;
+        return p->elem;
+    }
+    // 重载输出流，输出链表元素
+    friend ostream &operator <<(ostream &output, const List &list) {
+        output << '[';
+        for (Node<T> *p = list.head->next; p != list.head; p = p->next) {
+            output << *p;
+            if (p->next != list.head) output << ", ";
+        }
+        output << ']';
+        return output;
+    }
+
+    friend ostream &operator <<(ostream &output, const List *&list) {
+        output << '[';
+        for (Node<T> *p = list->head->next; p != list->head; p = p->next) {
+            output << *p;
+            if (p->next != list->head) output << ", ";
+        }
+        output << ']';
+        return output;
+    }
+    // 获得链表长度
+    int size() const {
+        return length;
+    }
+    // 判断链表是否为空，空则返回true
+    bool isEmpty() const {
+        return head->next == head;
+    }
+    // 根据索引值（从 1 开始）获取节点指针，若获取失败返回空指针
+    // 从离目标较近的一端开始遍历
+    Node<T>* getNode(int idx) {
+        if (idx < 0 || idx > length) {
+            cerr << "无效的索引值。" << endl;
+            return nullptr;
+        }
+        if (idx == 0) return nullptr;
+        Node<T> *p;
+        if (idx <= length / 2) {
+            p = head->next;
+            for (int i = 1; i < idx; i++) p = p->next;
+        } else {
+            p = head->prev;
+            for (int i = length; i > idx; i--) p = p->prev;
+        }
+        return p;
+    }
+    // 在指定节点后插入节点，返回插入的元素的指针，若插入失败返回空指针
+    Node<T>* add(T val, Node<T> *pos) {
+        Node<T> *item = newNode(std::move(val));
+        if (!item) {
+            cerr << "内存分配失败.请检查剩余内存是否充足。" << endl;
+            return nullptr;
+        }
+        item->next		 = pos->next;
+        pos->next		 = item;
+        item->next->prev = item;
+        item->prev		 = pos;
+        length++;
+        return item;
+    }
+
+    Node<T>* add(T val, int pos) {
+        return add(std::move(val), getNode(pos));
+    }
+    // 在链表末尾插入元素
+    Node<T>* append(T val) {
+        return add(std::move(val), head->prev);
+    }
+    // 删除指定位置的节点，返回被删除节点后一个节点的指针，若删除失败返回空指针
+    Node<T>* del(Node<T> *pos) {
+        if (pos == nullptr) {
+            return nullptr;
+        }
+        if (pos == head) {
+            cerr << "不能删除链表头元素。" << endl;
+            return nullptr;
+        }
+        pos->prev->next = pos->next;
+        pos->next->prev = pos->prev;
+        Node<T> *ret = pos->next;
+        freeNode(pos);
+        length--;
+        return ret;
+    }
+
+    Node<T>* del(int pos) {
+        return del(getNode(pos));
+    }
+    // 删除第一个值为val的节点
+    Node<T>* delByValue(T val) {
+        return del(find(val));
+    }
+    // 删除末尾元素
+    Node<T>* pop() {
+        return del(head->prev);
+    }
+    // 修改链表元素，若修改成功返回改节点指针，若修改失败则返回空指针
+    Node<T>* modify(Node<T> *pos, T val) {
+        if (pos == nullptr) {
+            return nullptr;
+        }
+        if (pos == head) {
+            cerr << "不能修改链表头元素。" << endl;
+            return nullptr;
+        }
+        pos->elem = std::move(val);
+        return pos;
+    }
+
+    Node<T>* modify(int pos, T val) {
+        return modify(getNode(pos), std::move(val));
+    }
+    // 查找第一个值为val的节点
+    Node<T>* find(T val) {
+        for (Node<T> *p = head->next; p != head; p = p->next) {
+            if (p->elem == val) return p;
+        }
+        return nullptr;
+    }
+    // 清空并重置链表
+    int clear() {
+        for (Node<T> *p = head->next, *next; p != head; p = next) {
+            next = p->next;
+            freeNode(p);
+        }
+        head->prev = head;
+        head->next = head;
+        length = 0;
+        return 0;
+    }
+    // 返回链表第一个节点的指针
+    Node<T>* begin() const {
+        return head->next;
+    }
+    // 返回链表最后一个节点的后一个元素的指针（即头节点的指针）
+    Node<T>* end() const {
+        return head;
+    }
+
+private:
+    Node<T> *head;
+    int length;		// 元素个数，随增删维护
+
+    static Node<T>* newNode(T val) {
+        void *mem = Alloc::allocate();
+        if (!mem) return nullptr;
+        return new (mem) Node<T>{std::move(val), nullptr, nullptr};
+    }
+    // 分配头节点并自环
+    static Node<T>* newHead() {
+        Node<T> *node = newNode(T(-1));
+        if (!node) {
+            cerr << "内存分配失败.请检查剩余内存是否充足。" << endl;
+            exit(1);
+        }
+        node->prev = node;
+        node->next = node;
+        return node;
+    }
+
+    static void freeNode(Node<T> *node) {
+        node->~Node<T>();
+        Alloc::deallocate(node);
+    }
+
+};
+
+struct ReaderLoan;
+
+// 借阅记录：一次借阅在用户的 books 与图书的 readers 中各占一个链表节点，
+// 两个节点互相指向对方，归还或删除时可直接从两个链表中摘除，无需按值查找
+struct BookLoan {
+    Node<BookInfo> *book;		// 借阅的图书
+    Node<ReaderLoan> *peer;		// 图书 readers 链表中对应的节点
+
+    BookLoan(): book(nullptr), peer(nullptr) {}
+
+    explicit BookLoan(int): book(nullptr), peer(nullptr) {}
+
+    BookLoan(Node<BookInfo> *b, Node<ReaderLoan> *p): book(b), peer(p) {}
+
+    // 输出借阅图书的编号
+    friend ostream &operator <<(ostream &output, const BookLoan &loan);
+};
+
+struct ReaderLoan {
+    Node<UserInfo> *user;		// 借阅者
+    Node<BookLoan> *peer;		// 用户 books 链表中对应的节点
+
+    ReaderLoan(): user(nullptr), peer(nullptr) {}
+
+    explicit ReaderLoan(int): user(nullptr), peer(nullptr) {}
+
+    ReaderLoan(Node<UserInfo> *u, Node<BookLoan> *p): user(u), peer(p) {}
+
+    // 输出借阅者的编号
+    friend ostream &operator <<(ostream &output, const ReaderLoan &loan);
+};
+
+class UserInfo {
+public:
+    string name;					// 姓名
+    string password;				// 密码
+    int identifier;					// 编号
+    int type;						// 用户类型
+    List<BookLoan> books;			// 已借阅的书籍
+    size_t lineOffset = 0;			// 该记录在用户文件中的位置
+    size_t lineLength = 0;			// 行长度（不含换行），为 0 表示已修改，保存时需重新生成
+    uint64_t serial = 0;			// 加入链表的次序，即在链表中的先后
+
+    UserInfo(): identifier(-1), type(-1) {}
+
+    UserInfo(int n): identifier(n), type(0) {}
+
+    UserInfo(string reader, int id, int _type):
+        name(reader), identifier(id), type(_type) {}
+
+    UserInfo(string reader, string pwd, int id, int _type):
+        name(reader), password(pwd), identifier(id), type(_type) {}
+
+    friend ostream &operator <<(ostream &output, const UserInfo &reader) {
+        output << "{\"" << reader.name << "\", \"" << reader.password << "\", " << reader.identifier
+               << ", " << reader.type << ", " << reader.books << "}";
+        return output;
+    }
+
+    friend ostream &operator <<(ostream &output, const UserInfo *&reader) {
+        output << "{\"" << reader->name << "\", \"" << reader->password << "\", " << reader->identifier
+               << ", " << reader->type << ", " << reader->books << "}";
+        return output;
+    }
+
+};
+
+class BookInfo {
+public:
+    string name;					// 名称
+    int identifier;					// 编号
+    int quantity;					// 数量
+    List<ReaderLoan> readers;		// 借阅该书的读者
+    size_t lineOffset = 0;			// 该记录在图书文件中的位置
+    size_t lineLength = 0;			// 行长度（不含换行），为 0 表示已修改，保存时需重新生成
+    uint64_t serial = 0;			// 加入链表的次序，即在链表中的先后
+
+    BookInfo(): identifier(-1), quantity(-1) {}
+
+    BookInfo(int n): identifier(n), quantity(1) {}
+
+    BookInfo(string book, int id, int num):
+        name(book), identifier(id), quantity(num) {}
+
+    friend ostream &operator <<(ostream &output, const BookInfo &book) {
+        output << "{\"" << book.name << "\", " << book.identifier << ", "
+               << book.quantity << ", " << book.readers;
+        output << "}";
+        return output;
+    }
+
+    friend ostream &operator <<(ostream &output, const BookInfo *&book) {
+        output << "{\"" << book->name << "\", " << book->identifier << ", "
+               << book->quantity << ", " << book->readers << "}";
+        return output;
+    }
+
+};
+
+inline ostream &operator <<(ostream &output, const BookLoan &loan) {
+    output << (loan.book ? loan.book->elem.identifier : -1);
+    return output;
+}
+
+inline ostream &operator <<(ostream &output, const ReaderLoan &loan) {
+    output << (loan.user ? loan.user->elem.identifier : -1);
+    return output;
+}
+
+// 数据变更的监听者，如界面中的表格模型；删除通知在节点释放之前发出，其余通知在改动完成之后发出
+class LibraryListener {
+public:
+    virtual ~LibraryListener() {}
+    virtual void bookAdded(Node<BookInfo> *) {}
+    virtual void userAdded(Node<UserInfo> *) {}
+    virtual void bookRemoved(Node<BookInfo> *) {}
+    virtual void userRemoved(Node<UserInfo> *) {}
+    virtual void bookChanged(int, Node<BookInfo> *) {}	// 名称、编号或数量改变，另带修改前的编号
+    virtual void userChanged(int, Node<UserInfo> *) {}	// 名称、编号、密码或类型改变，另带修改前的编号
+    virtual void loanAdded(Node<UserInfo> *, Node<BookInfo> *) {}
+    virtual void loanRemoved(Node<UserInfo> *, Node<BookInfo> *) {}
+    virtual void reloaded() {}	// 读取文件后，成批加入的记录不逐条通知
+};
+
+// 图书馆数据。公开的查询方法持有读锁，修改方法持有写锁，可在多个线程中同时调用：
+// 查找、导出等只读操作可并行，借还等修改依次进行；修改方法在同一线程中发出通知，监听者可在其中继续查询。
+// 返回的节点在被删除前有效，其他线程需要连续使用节点或直接遍历 books/users 时应持有 readLock()
+class Library {
+public:
+    List<BookInfo> books;
+    List<UserInfo> users;
+    const char *bookPath;	// 当前数据文件路径，指向库内保存的副本
+    const char *userPath;
+    char DIVIDE_CHAR;		// 数据文件的分隔符
+    int danglingIDs = 0;	// 最近一次读取时无法对应到图书或用户的借阅编号数
+
+    explicit Library(char divide = ','): DIVIDE_CHAR(divide) {
+        setPaths("", "");
+    }
+
+    Library(const char *userFile, const char *bookFile, char divide = ','): DIVIDE_CHAR(divide) {
+        setPaths("", "");
+        read(userFile, bookFile);
+    }
+
+    ~Library() {}
+    // 从文件读取数据；库为空时随后重放该数据文件的日志，并开始记录之后的改动
+    // 库中已有数据时（导入）合并后的数据不再对应任何一份日志，在下次完整保存前不记录日志
+    int read(const char *userFile, const char *bookFile);
+    // 写入图书、用户数据文件，并在其旁写入二进制快照供下次快速加载
+    // 写入的是当前数据文件时只重新生成修改过的行，没有改动的文件直接跳过，日志以新文件为基准重新开始
+    int write(const char *userFile, const char *bookFile);
+    // 保存改动：日志较小时只需把日志落盘，日志过大或未打开时完整写出数据文件（压实）
+    int save();
+    // 保存时是否需要完整写出数据文件
+    bool needsRewrite() const {
+        auto lock = readLock();
+        return !journal.isOpen() || journal.size() >= COMPACT_SIZE;
+    }
+    // 是否有尚未保存的改动
+    bool hasUnsavedChanges() {
+        auto lock = readLock();
+        if (journal.isOpen()) return !journal.isCommitted();
+        return booksChanged || usersChanged;
+    }
+    // 放弃上次保存之后的改动（仅影响文件，内存中的数据不变），退出且不保存时调用
+    void discard() {
+        auto lock = readLock();	// 日志只在写锁下打开与关闭
+        journal.rollback();
+    }
+    // 放弃未保存的改动并停止记录日志，之后的改动只在内存中，保存时完整写出数据文件；
+    // 供回放、试验等不应改动数据文件的场合在读取后调用
+    void detachJournal() {
+        auto lock = writeLock();
+        journal.rollback();
+        journal.close();
+    }
+    // 写入文件信息
+    int writeBook(const char *bookFile);
+
+    int writeUser(const char *userFile);
+    // 准备保存到给定文件的内容：之后可在其他线程调用 run()，期间仍可修改数据，
+    // 完成后须回到本线程调用 finishSave；同一时间只应有一次保存在进行
+    // 导出到其他文件不改动任何状态，只持有读锁，可与查找及其他导出并行
+    std::unique_ptr<SaveJob> prepareSave(const char *userFile, const char *bookFile);
+    // 保存完成后更新各行位置与日志，返回写入结果
+    int finishSave(SaveJob &job);
+    // 按编号查找图书
+    Node<BookInfo>* findBook(int id) {
+        auto lock = readLock();
+        return bookIndex.find(id);
+    }
+    // 按编号查找用户
+    Node<UserInfo>* findUser(int id) {
+        auto lock = readLock();
+        return userIndex.find(id);
+    }
+    // 按名称查找图书
+    Node<BookInfo>* findBook(string name) {
+        auto lock = readLock();
+        return bookNameIndex.find(name);
+    }
+    // 按名称查找图书（模糊查找），返回一个链表，存有目标图书的节点指针
+    List<Node<BookInfo>*> fuzzyFindBook(const string &name);
+    // 按名称查找用户
+    Node<UserInfo>* findUser(string name) {
+        auto lock = readLock();
+        return userNameIndex.find(name);
+    }
+    // 按名称查找用户（模糊查找），返回一个链表，存有目标用户的节点指针
+    List<Node<UserInfo>*> fuzzyFindUser(const string &name);
+    // 分页模糊查找：从 from 之后（forward 为 true）或之前取至多 limit 本名称包含 name 的图书，按链表顺序追加到 out
+    // from 为空指针时从第一本（或最后一本）开始；name 为空时即逐页浏览全部图书。只访问凑满一页所需的记录，
+    // 且至多检查 budget 个候选；返回最后检查的记录，可作为 from 继续查找，已查找到链表一端时返回空指针
+    // 分几次调用时，from 可能已在两次调用之间被删除，调用者可借助 removals() 判断
+    Node<BookInfo>* fuzzyFindBook(const string &name, Node<BookInfo> *from, bool forward, size_t limit,
+                                  std::vector<Node<BookInfo>*> &out, size_t budget = SIZE_MAX);
+
+    Node<UserInfo>* fuzzyFindUser(const string &name, Node<UserInfo> *from, bool forward, size_t limit,
+                                  std::vector<Node<UserInfo>*> &out, size_t budget = SIZE_MAX);
+    // 读锁：持有期间数据不被修改，取得的节点不会被删除；同一线程可重复加锁
+    std::shared_lock<RWLock> readLock() const {
+        return std::shared_lock<RWLock>(dataLock);
+    }
+    // 写锁：需要把查找与随后的修改合为一步时持有，期间其他线程的读写都要等待
+    std::unique_lock<RWLock> writeLock() {
+        return std::unique_lock<RWLock>(dataLock);
+    }
+    // 已删除的记录数，分几次加锁查找的线程据此判断游标是否可能已失效
+    uint64_t removals() const {
+        return removedCount;
+    }
+    // 添加图书信息
+    Node<BookInfo>* add(BookInfo book);
+    // 添加用户信息
+    Node<UserInfo>* add(UserInfo user);
+    // 能否加入该图书：编号与数量不能为负，编号不能与已有图书重复；检查与随后的加入应在同一写锁内
+    bool canAdd(const BookInfo &book) {
+        return book.identifier >= 0 && book.quantity >= 0 && !findBook(book.identifier);
+    }
+    // 能否加入该用户：编号不能为负，也不能与已有用户重复
+    bool canAdd(const UserInfo &user) {
+        return user.identifier >= 0 && !findUser(user.identifier);
+    }
+    // 能否把 src 修改为 target：编号不能与其他图书重复，数量不能少于借出数
+    bool canModify(Node<BookInfo> *src, const BookInfo &target) {
+        Node<BookInfo> *same = findBook(target.identifier);
+        return target.identifier >= 0 && (!same || same == src) && target.quantity >= src->elem.readers.size();
+    }
+    // 能否把 src 修改为 target：编号不能与其他用户重复
+    bool canModify(Node<UserInfo> *src, const UserInfo &target) {
+        Node<UserInfo> *same = findUser(target.identifier);
+        return target.identifier >= 0 && (!same || same == src);
+    }
+    // 删除图书节点，force=true 开启强制删除
+    Node<BookInfo>* del(Node<BookInfo>* book, bool force = false);
+    // 删除用户节点，force=true 开启强制删除,并强制归还该书
+    Node<UserInfo>* del(Node<UserInfo>* user, bool force = false);
+
+    Node<BookInfo>* delBook(int id, bool force = false) {
+        auto lock = writeLock();
+        return del(findBook(id), force);
+    }
+
+    Node<UserInfo>* delUser(int id, bool force = false) {
+        auto lock = writeLock();
+        return del(findUser(id), force);
+    }
+
+    Node<BookInfo>* delBook(string name, bool force = false) {
+        auto lock = writeLock();
+        return del(findBook(name), force);
+    }
+
+    Node<UserInfo>* delUser(string name, bool force = false) {
+        auto lock = writeLock();
+        return del(findUser(name), force);
+    }
+
+    Node<BookInfo>* modify(Node<BookInfo>* src, BookInfo target);
+
+    Node<UserInfo>* modify(Node<UserInfo>* src, UserInfo target);
+
+    Node<BookInfo>* updateBook(int id, BookInfo target) {
+        auto lock = writeLock();
+        return modify(findBook(id), target);
+    }
+
+    Node<UserInfo>* updateUser(int id, UserInfo target) {
+        auto lock = writeLock();
+        return modify(findUser(id), target);
+    }
+
+    Node<BookInfo>* updateBook(string name, BookInfo target) {
+        auto lock = writeLock();
+        return modify(findBook(name), target);
+    }
+
+    Node<UserInfo>* updateUser(string name, UserInfo target) {
+        auto lock = writeLock();
+        return modify(findUser(name), target);
+    }
+    // 修改图书编号，同步更新编号索引
+    Node<BookInfo>* modifyID(Node<BookInfo>* book, int id);
+    // 修改图书名称，同步更新名称索引
+    Node<BookInfo>* modifyName(Node<BookInfo>* book, string name);
+    // 修改图书数量
+    Node<BookInfo>* setQuantity(Node<BookInfo>* book, int quantity);
+    // 修改用户编号，同步更新编号索引
+    Node<UserInfo>* modifyID(Node<UserInfo>* user, int id);
+    // 修改用户名称，同步更新名称索引
+    Node<UserInfo>* modifyName(Node<UserInfo>* user, string name);
+    // 修改用户密码
+    Node<UserInfo>* setPassword(Node<UserInfo>* user, string password);
+    // 修改用户类型
+    Node<UserInfo>* setType(Node<UserInfo>* user, int type);
+
+    int borrowBook(Node<UserInfo>* userNode, Node<BookInfo>* bookNode);
+
+    int borrowBook(int userID, int bookID) {
+        auto lock = writeLock();
+        return borrowBook(findUser(userID), findBook(bookID));
+    }
+
+    int borrowBook(string userName, string bookName) {
+        auto lock = writeLock();
+        return borrowBook(findUser(userName), findBook(bookName));
+    }
+
+    int returnBook(Node<UserInfo>* userNode, Node<BookInfo>* bookNode);
+
+    int returnBook(int userID, int bookID) {
+        auto lock = writeLock();
+        return returnBook(findUser(userID), findBook(bookID));
+    }
+
+    int returnBook(string userName, string bookName) {
+        auto lock = writeLock();
+        return returnBook(findUser(userName), findBook(bookName));
+    }
+    // 判断用户是否借阅了该书
+    bool hasBorrowed(Node<UserInfo>* userNode, Node<BookInfo>* bookNode);
+    // 检查借阅记录的双向链接：图书 readers 与用户 books 中的节点一一对应且互相指向，
+    // 都已登记在借阅索引中，且借出数不超过图书数量；返回发现的问题数，0 为一致
+    int checkLoans();
+    void addListener(LibraryListener *listener) {
+        auto lock = writeLock();
+        listeners.push_back(listener);
+    }
+
+    void removeListener(LibraryListener *listener) {
+        auto lock = writeLock();
+        listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+    }
+    // 判断用户是否为管理员
+    bool isAdmin(Node<UserInfo>* user) {
+        auto lock = readLock();
+        return user->elem.type == 1;
+    }
+    // 密码验证，登录成功返回该用户节点指针，失败返回空指针
+    Node<UserInfo>* login(string userName, string password);
+
+protected:
+    typedef std::pair<Node<UserInfo>*, Node<BookInfo>*> LoanKey;
+
+    HashIndex<int, Node<BookInfo>*> bookIndex;			// 图书编号索引
+    HashIndex<int, Node<UserInfo>*> userIndex;			// 用户编号索引
+    HashIndex<string, Node<BookInfo>*> bookNameIndex;	// 图书名称索引
+    HashIndex<string, Node<UserInfo>*> userNameIndex;	// 用户名称索引
+    // 键重复时索引中只有链表中最靠前的节点，同键的其他节点按链表顺序记在以下各表，删除与改名只需处理同键的节点
+    HashIndex<int, std::vector<Node<BookInfo>*>> bookIDDups;		// 编号重复的其他图书
+    HashIndex<int, std::vector<Node<UserInfo>*>> userIDDups;		// 编号重复的其他用户
+    HashIndex<string, std::vector<Node<BookInfo>*>> bookNameDups;	// 名称重复的其他图书
+    HashIndex<string, std::vector<Node<UserInfo>*>> userNameDups;	// 名称重复的其他用户
+    uint64_t serials = 0;	// 下一条加入链表的记录的次序
+    NgramIndex<Node<BookInfo>*> bookGrams;	// 图书名称的模糊查找索引
+    NgramIndex<Node<UserInfo>*> userGrams;	// 用户名称的模糊查找索引
+    HashIndex<LoanKey, std::vector<Node<BookLoan>*>> loans;	// （用户, 图书）-> 借阅记录，按借阅先后排列
+    string bookFileName;	// bookPath/userPath 所指的路径副本
+    string userFileName;
+    Journal journal;		// 上次完整保存之后的改动日志
+    std::vector<LibraryListener*> listeners;
+    mutable RWLock dataLock;				// 见 readLock()/writeLock()
+    std::atomic<uint64_t> removedCount{0};	// 见 removals()
+    int generation = 0;			// 读取数据的次数，用于识别跨越了读取的保存
+    bool booksChanged = true;	// 内存中的图书与图书文件是否不一致
+    bool usersChanged = true;	// 内存中的用户与用户文件是否不一致
+    snapshot::FileStamp bookFileStamp = {};	// 上次读写后图书文件的大小与修改时间
+    snapshot::FileStamp userFileStamp = {};
+    char bookFileDivide = ',';	// 图书文件现有内容所用的分隔符，与 DIVIDE_CHAR 不同时保存须重新生成每一行
+    char userFileDivide = ',';
+
+    static constexpr uint64_t COMPACT_SIZE = 1 << 22;	// 日志超过该大小时保存改为完整写出数据文件
+    static constexpr size_t SAVING = SIZE_MAX;			// 行长度取此值表示该行已交给进行中的保存
+
+    void setPaths(const char *userFile, const char *bookFile);
+    // 以当前数据文件为基准打开日志，replay 为 true 时先重放其中基准一致的记录
+    int openJournal(bool replay);
+    // 重放一条日志记录，记录损坏或无法执行时返回 1
+    int replayRecord(Journal::Reader &record);
+    // 节点信息修改后调用：标记需重新生成的行，并记录修改后的完整信息，oldID 为修改前的编号
+    // 编号改变时借阅了该书的用户所在行也随之改变
+    void modified(int oldID, Node<BookInfo> *book);
+
+    void modified(int oldID, Node<UserInfo> *user);
+    // 读取数据文件（或与之一致的快照）到链表
+    int loadData(const char *userFile, const char *bookFile);
+
+    // 为图书 readers 中已挂入的节点补上用户一侧，完成一条借阅记录
+    Node<BookLoan>* pairLoan(Node<UserInfo> *user, Node<BookInfo> *book, Node<ReaderLoan> *reader);
+    // 从用户与图书两侧同时摘除一条借阅记录
+    void unlinkLoan(Node<BookLoan> *loan);
+    // 沿链表逐条比对名称取一页结果，用于索引无法处理的查询
+    template<class T>
+    static Node<T>* scanPage(const List<T> &list, const string &name, Node<T> *from, bool forward, size_t limit,
+                             std::vector<Node<T>*> &out, size_t budget) {
+        size_t first = out.size();
+        Node<T> *last = from;
+        Node<T> *p = from ? (forward ? from->next : from->prev) : (forward ? list.begin() : list.end()->prev);
+        for (; p != list.end() && out.size() - first < limit && budget; p = forward ? p->next : p->prev, budget--) {
+            if (p->elem.name.find(name) != string::npos) out.push_back(p);
+            last = p;
+        }
+        if (!forward) std::reverse(out.begin() + first, out.end());
+        return p == list.end() ? nullptr : last;
+    }
+    // 向所有监听者发出通知
+    template<class... Args>
+    void notify(void (LibraryListener::*event)(Args...), Args... args) {
+        for (auto *listener : listeners) (listener->*event)(args...);
+    }
+    // 标记记录所在行需在保存时重新生成
+    void touch(Node<BookInfo> *book) {
+        book->elem.lineLength = 0;
+        booksChanged = true;
+    }
+
+    void touch(Node<UserInfo> *user) {
+        user->elem.lineLength = 0;
+        usersChanged = true;
+    }
+    template<class T>
+    static bool hasTouched(const List<T> &list) {
+        for (auto *p = list.begin(); p != list.end(); p = p->next) {
+            if (!p->elem.lineLength) return true;
+        }
+        return false;
+    }
+    // 生成一行数据文件内容（不含换行）
+    void formatLine(string &line, const BookInfo &book) const;
+
+    void formatLine(string &line, const UserInfo &user) const;
+
+    void appendField(string &line, const string &field) const {
+        line += DIVIDE_CHAR;
+        line += field;
+    }
+    // 收集一个文件的内容：当前数据文件未被其他程序改动、且分隔符与读入时相同时，未修改的行只记录其在原文件中的位置
+    template<class T>
+    void prepareFile(SaveJob::File &file, const char *fileName, const string &currentName,
+                     List<T> &list, bool &changed, const snapshot::FileStamp &stamp, char fileDivide) {
+        file.fileName = fileName;
+        file.current = currentName == fileName;
+        bool copy = file.current && fileDivide == DIVIDE_CHAR && isUnchanged(fileName, stamp);
+        if (copy && !changed) return;
+        file.skip = false;
+        file.sourceStamp = stamp;
+        file.lines.reserve(list.size());
+        string line;
+        for (auto *p = list.begin(); p != list.end(); p = p->next) {
+            size_t length = p->elem.lineLength;
+            if (copy && length && length != SAVING) {
+                file.addCopy(p, p->elem.lineOffset, length);
+            } else {
+                formatLine(line, p->elem);
+                file.addText(p, line);
+            }
+            if (file.current && !length) p->elem.lineLength = SAVING;
+        }
+        if (file.current) changed = false;
+    }
+    // 按写入结果更新各行位置；期间被修改过的行保持待生成
+    template<class T>
+    static void finishFile(const SaveJob::File &file, List<T> &list, bool &changed,
+                           snapshot::FileStamp &stamp, char &fileDivide, char divide, bool same) {
+        if (file.skip || !file.current || !same) return;
+        if (file.state) {
+            for (auto *p = list.begin(); p != list.end(); p = p->next) {
+                if (p->elem.lineLength == SAVING) p->elem.lineLength = 0;
+            }
+            changed = true;
+            return;
+        }
+        auto line = file.lines.begin();
+        for (auto *p = list.begin(); p != list.end() && line != file.lines.end(); p = p->next) {
+            while (line != file.lines.end() && line->node != p) ++line;
+            if (line == file.lines.end()) break;
+            if (p->elem.lineLength) {
+                p->elem.lineOffset = line->offset;
+                p->elem.lineLength = line->length;
+            }
+            ++line;
+        }
+        snapshot::stamp(file.fileName.c_str(), stamp);
+        fileDivide = divide;
+    }
+    // 文件的大小与修改时间是否仍与记录的一致
+    static bool isUnchanged(const char *fileName, const snapshot::FileStamp &recorded) {
+        snapshot::FileStamp now;
+        return snapshot::stamp(fileName, now) && now == recorded;
+    }
+
+    template<class T>
+    static const string &nameOf(Node<T> *node) {
+        return node->elem.name;
+    }
+
+    template<class T>
+    static bool bySerial(const Node<T> *a, const Node<T> *b) {
+        return a->elem.serial < b->elem.serial;
+    }
+    // 登记节点到索引，键重复时保留链表中靠前（serial 较小）的节点，其余按链表顺序记入 dups
+    template<class K, class T>
+    static void indexKey(HashIndex<K, Node<T>*> &index, HashIndex<K, std::vector<Node<T>*>> &dups,
+                         K T::*key, Node<T> *node) {
+        const K &value = node->elem.*key;
+        Node<T> **first = index.get(value);
+        if (!first) {
+            index.insert(value, node);
+            return;
+        }
+        if (node->elem.serial < (*first)->elem.serial) std::swap(*first, node);
+        std::vector<Node<T>*> &rest = dups.obtain(value);
+        rest.insert(std::upper_bound(rest.begin(), rest.end(), node, bySerial<T>), node);
+    }
+    // 从索引移除节点，若存在同键的其他节点则由其中最靠前的接替
+    template<class K, class T>
+    static void unindexKey(HashIndex<K, Node<T>*> &index, HashIndex<K, std::vector<Node<T>*>> &dups,
+                           K T::*key, Node<T> *node) {
+        const K &value = node->elem.*key;
+        Node<T> **first = index.get(value);
+        if (!first) return;
+        std::vector<Node<T>*> *rest = dups.get(value);
+        if (*first == node) {
+            if (!rest) {
+                index.erase(value);
+                return;
+            }
+            *first = rest->front();
+            rest->erase(rest->begin());
+        } else {
+            if (!rest) return;
+            auto it = std::lower_bound(rest->begin(), rest->end(), node, bySerial<T>);
+            if (it == rest->end() || *it != node) return;
+            rest->erase(it);
+        }
+        if (rest->empty()) dups.erase(value);
+    }
+
+    void indexBook(Node<BookInfo> *book) {
+        indexKey(bookIndex, bookIDDups, &BookInfo::identifier, book);
+        indexKey(bookNameIndex, bookNameDups, &BookInfo::name, book);
+        bookGrams.insert(book->elem.name, book);
+    }
+
+    void indexUser(Node<UserInfo> *user) {
+        indexKey(userIndex, userIDDups, &UserInfo::identifier, user);
+        indexKey(userNameIndex, userNameDups, &UserInfo::name, user);
+        userGrams.insert(user->elem.name, user);
+    }
+
+    void unindexBook(Node<BookInfo> *book) {
+        unindexKey(bookIndex, bookIDDups, &BookInfo::identifier, book);
+        unindexKey(bookNameIndex, bookNameDups, &BookInfo::name, book);
+        bookGrams.erase(book->elem.name, book);
+    }
+
+    void unindexUser(Node<UserInfo> *user) {
+        unindexKey(userIndex, userIDDups, &UserInfo::identifier, user);
+        unindexKey(userNameIndex, userNameDups, &UserInfo::name, user);
+        userGrams.erase(user->elem.name, user);
+    }
+
+    // 生成快照内容；current 为 false 时是导出到其他文件，不记录行位置
+    void buildSnapshot(snapshot::Tables &tables, bool current) const;
+    // 从快照加载，快照不存在、已过期或损坏时返回 1 且不修改任何数据
+    int loadSnapshot(const char *userFile, const char *bookFile);
+
+    int openDataFile(MappedFile &file, const char *fileName);
+    // 读取时加入一条记录：只加入链表与索引，不标记修改、不写日志，也不逐条通知（读取结束后统一发出 reloaded）
+    // 调用者持有写锁；内存不足时返回空指针
+    Node<BookInfo>* load(BookInfo book) {
+        book.serial = serials++;
+        Node<BookInfo> *ret = books.append(std::move(book));
+        if (ret) indexBook(ret);
+        return ret;
+    }
+
+    Node<UserInfo>* load(UserInfo user) {
+        user.serial = serials++;
+        Node<UserInfo> *ret = users.append(std::move(user));
+        if (ret) indexUser(ret);
+        return ret;
+    }
+    // 撤销读取到一半的数据：删除 lastBook、lastUser 之后加入的记录（此时尚未建立借阅记录）
+    void unload(Node<BookInfo> *lastBook, Node<UserInfo> *lastUser);
+    // 将解析好的图书行依次加入链表，base 为映射的文件内容，用于记录各行位置；内存不足时返回 1
+    int bookDataReader(const std::vector<CsvChunk> &chunks, const char *base);
+    // 将解析好的用户行依次加入链表
+    int userDataReader(const std::vector<CsvChunk> &chunks, const char *base);
+    // 链接阶段：把解析出的借阅编号一次性解析为节点并建立借阅记录，返回无法解析的编号数
+    // firstUser/firstBook 为本次读入的第一个节点，其后节点与各块中的行一一对应
+    // 先按图书文件挂入读者，再按用户文件逐条与之配对，两边顺序均与文件一致
+    int linkLoans(const std::vector<CsvChunk> &userChunks, Node<UserInfo> *firstUser,
+                  const std::vector<CsvChunk> &bookChunks, Node<BookInfo> *firstBook);
+
+};
+
+extern Library lib;
+extern int loginUserID;
+extern bool isLoginAdmin;
+
+#endif // LIBRARYDATA_H
@@ -0,0 +1,208 @@
+#ifndef NGRAMINDEX_H
+#define NGRAMINDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "hashindex.h"
+
+// 名称的 N 元组倒排索引，用于子串（模糊）查找
+// 以 UTF-8 码点为单位，登记名称中出现的每个单字与相邻双字，
+// 查找时对查询串各元组的倒排表求交集得到候选，再逐个用 string::find 校验，
+// 因此结果与逐条 find != npos 扫描完全一致，且按登记顺序（即链表顺序）返回
+template<class P> class NgramIndex {
+public:
+    typedef std::pair<uint64_t, P> Posting;	// （登记序号, 节点指针）
+
+    NgramIndex(): nextSeq(0) {}
+
+    NgramIndex(const NgramIndex &) = delete;
+    NgramIndex &operator =(const NgramIndex &) = delete;
+    // 登记名称；节点此前登记过时沿用原序号，以保持改名后的结果顺序
+    void insert(const std::string &name, P node) {
+        uint64_t &seq = seqs.obtain(node);
+        if (!seq) seq = ++nextSeq;
+        std::vector<uint64_t> grams;
+        split(name, grams);
+        for (uint64_t gram : grams) {
+            std::vector<Posting> &list = postings.obtain(gram);
+            if (list.empty() || list.back().first < seq) {
+                list.push_back(Posting(seq, node));
+            } else {
+                list.insert(std::lower_bound(list.begin(), list.end(), Posting(seq, P())), Posting(seq, node));
+            }
+        }
+    }
+    // 撤销名称登记，保留节点的序号（改名时先 erase 再 insert）
+    void erase(const std::string &name, P node) {
+        uint64_t *seq = seqs.get(node);
+        if (!seq) return;
+        std::vector<uint64_t> grams;
+        split(name, grams);
+        for (uint64_t gram : grams) {
+            std::vector<Posting> *list = postings.get(gram);
+            if (!list) continue;
+            auto it = std::lower_bound(list->begin(), list->end(), Posting(*seq, P()));
+            if (it != list->end() && it->first == *seq) list->erase(it);
+            if (list->empty()) postings.erase(gram);
+        }
+    }
+    // 释放节点序号，节点删除后调用
+    void release(P node) {
+        seqs.erase(node);
+    }
+    // 查找名称包含 query 的节点，按登记顺序写入 out
+    // 返回 false 表示查询串为空或不是合法 UTF-8，无法使用索引，调用方需退回全表扫描
+    template<class NameOf>
+    bool search(const std::string &query, NameOf nameOf, std::vector<P> &out) const {
+        std::vector<uint64_t> grams;
+        if (!split(query, grams)) return false;
+        if (grams.empty()) return false;
+        // 查询串不少于两个字时，双字倒排表已足够，无需再与单字表求交集
+        if (grams.back() & BIGRAM) {
+            grams.erase(grams.begin(), std::lower_bound(grams.begin(), grams.end(), BIGRAM));
+        }
+        // 先取最短的倒排表，再依次与其余表求交集
+        std::vector<const std::vector<Posting>*> lists;
+        for (uint64_t gram : grams) {
+            const std::vector<Posting> *list = postings.get(gram);
+            if (!list) return true;
+            lists.push_back(list);
+        }
+        std::sort(lists.begin(), lists.end(),
+                  [](const std::vector<Posting> *a, const std::vector<Posting> *b) {
+            return a->size() < b->size();
+        });
+        std::vector<Posting> cand(*lists[0]);
+        for (size_t i = 1; i < lists.size() && !cand.empty(); i++) {
+            std::vector<Posting> next;
+            auto it = lists[i]->begin();
+            for (const Posting &p : cand) {
+                it = std::lower_bound(it, lists[i]->end(), Posting(p.first, P()));
+                if (it == lists[i]->end()) break;
+                if (it->first == p.first) next.push_back(p);
+            }
+            cand.swap(next);
+        }
+        for (const Posting &p : cand) {
+            if (nameOf(p.second).find(query) != std::string::npos) out.push_back(p.second);
+        }
+        return true;
+    }
+
+    // 分页查找：从节点 from 之后（forward 为 true）或之前按登记顺序取至多 limit 个结果，按登记顺序写入 out
+    // from 为空或未登记时从头（或尾）开始；只检查取到所需结果为止的候选，且至多检查 budget 个候选。
+    // resume 非空时写入最后检查的候选，可作为下次的 from 继续查找，候选已检查完时写入 P()。返回值同 search
+    template<class NameOf>
+    bool searchPage(const std::string &query, NameOf nameOf, P from, bool forward, size_t limit,
+                    std::vector<P> &out, size_t budget = SIZE_MAX, P *resume = nullptr) const {
+        if (resume) *resume = P();
+        std::vector<uint64_t> grams;
+        if (!split(query, grams)) return false;
+        if (grams.empty()) return false;
+        if (grams.back() & BIGRAM) {
+            grams.erase(grams.begin(), std::lower_bound(grams.begin(), grams.end(), BIGRAM));
+        }
+        std::vector<const std::vector<Posting>*> lists;
+        for (uint64_t gram : grams) {
+            const std::vector<Posting> *list = postings.get(gram);
+            if (!list) return true;
+            lists.push_back(list);
+        }
+        std::sort(lists.begin(), lists.end(),
+                  [](const std::vector<Posting> *a, const std::vector<Posting> *b) {
+            return a->size() < b->size();
+        });
+        // 沿最短的倒排表移动，其余各表用二分查找确认是否含有同一序号
+        uint64_t seq = from ? seqs.find(from) : 0;
+        const std::vector<Posting> &shortest = *lists[0];
+        size_t first = out.size();
+        auto accept = [&](const Posting &p) {
+            for (size_t i = 1; i < lists.size(); i++) {
+                auto it = std::lower_bound(lists[i]->begin(), lists[i]->end(), Posting(p.first, P()));
+                if (it == lists[i]->end() || it->first != p.first) return;
+            }
+            if (nameOf(p.second).find(query) != std::string::npos) out.push_back(p.second);
+        };
+        P last = from;
+        if (forward) {
+            auto it = seq ? std::lower_bound(shortest.begin(), shortest.end(), Posting(seq + 1, P()))
+                          : shortest.begin();
+            for (; it != shortest.end() && out.size() - first < limit && budget; ++it, budget--) {
+                accept(*it);
+                last = it->second;
+            }
+            if (resume && it != shortest.end()) *resume = last;
+        } else {
+            auto it = seq ? std::lower_bound(shortest.begin(), shortest.end(), Posting(seq, P()))
+                          : shortest.end();
+            for (; it != shortest.begin() && out.size() - first < limit && budget; budget--) {
+                accept(*--it);
+                last = it->second;
+            }
+            if (resume && it != shortest.begin()) *resume = last;
+            std::reverse(out.begin() + first, out.end());
+        }
+        return true;
+    }
+
+    void clear() {
+        postings.clear();
+        seqs.clear();
+        nextSeq = 0;
+    }
+
+private:
+    HashIndex<uint64_t, std::vector<Posting>> postings;	// 元组 -> 按序号排序的倒排表
+    HashIndex<P, uint64_t> seqs;						// 节点 -> 登记序号
+    uint64_t nextSeq;
+
+    static const uint64_t BIGRAM = 1ULL << 44;
+
+    // 解码一个 UTF-8 码点；非法字节按单字节记为 0x110000 + 字节值，并返回 false
+    static bool decode(const std::string &s, size_t &i, uint32_t &cp) {
+        unsigned char c = s[i];
+        int len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+        if (len == 1) {
+            cp = c;
+            i++;
+            return true;
+        }
+        if (len && i + len <= s.size()) {
+            uint32_t v = c & (0x7F >> len);
+            int k = 1;
+            for (; k < len && ((unsigned char)s[i + k] >> 6) == 0x2; k++) {
+                v = (v << 6) | ((unsigned char)s[i + k] & 0x3F);
+            }
+            if (k == len) {
+                cp = v;
+                i += len;
+                return true;
+            }
+        }
+        cp = 0x110000 + c;
+        i++;
+        return false;
+    }
+    // 拆分出去重后的单字与双字元组，串中含非法 UTF-8 时返回 false
+    static bool split(const std::string &s, std::vector<uint64_t> &grams) {
+        bool valid = true;
+        uint32_t prev, cp;
+        for (size_t i = 0; i < s.size(); ) {
+            bool first = i == 0;
+            valid &= decode(s, i, cp);
+            grams.push_back(cp);
+            if (!first) grams.push_back(BIGRAM | ((uint64_t)prev << 22) | cp);
+            prev = cp;
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        return valid;
+    }
+};
+
+template<class P> const uint64_t NgramIndex<P>::BIGRAM;
+
+#endif // NGRAMINDEX_H
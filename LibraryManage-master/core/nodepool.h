@@ -0,0 +1,89 @@
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+// 链表节点内存池（默认分配策略）
+// 每种节点类型共用一个池：按块批量申请内存，块大小逐次翻倍，
+// 释放的节点挂入空闲链表供下次复用，避免逐个 new/delete 造成的大量小块分配与内存碎片
+// 各线程可同时申请与归还（如查找线程构造结果链表），池以自旋锁保护，临界区只有几次指针操作
+template<class N> class NodePool {
+public:
+    // 申请一个节点大小的未初始化内存
+    static void *allocate() {
+        return instance().take();
+    }
+    // 归还由 allocate 申请的内存，调用前节点须已析构
+    static void deallocate(void *p) {
+        instance().give(p);
+    }
+
+private:
+    union Slot {
+        Slot *next;								// 空闲时指向下一个空闲槽位
+        alignas(N) unsigned char data[sizeof(N)];
+    };
+
+    struct Block {
+        Block *next;
+        Slot *slots;
+    };
+
+    static const size_t MIN_BLOCK = 32;		// 首块槽位数
+    static const size_t MAX_BLOCK = 4096;	// 单块槽位数上限
+
+    Block *blocks;		// 已申请的内存块
+    Slot *freeList;		// 空闲槽位链表
+    size_t blockSize;	// 下一块的槽位数
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+
+    NodePool(): blocks(nullptr), freeList(nullptr), blockSize(MIN_BLOCK) {}
+
+    NodePool(const NodePool &) = delete;
+    NodePool &operator =(const NodePool &) = delete;
+
+    // 池本身不析构：全局链表（如 lib）析构时仍要归还节点，内存在进程退出时由系统回收
+    static NodePool &instance() {
+        static NodePool *pool = new NodePool;
+        return *pool;
+    }
+
+    void *take() {
+        acquire();
+        if (!freeList) grow();
+        Slot *slot = freeList;
+        freeList = slot->next;
+        release();
+        return slot;
+    }
+
+    void give(void *p) {
+        Slot *slot = static_cast<Slot *>(p);
+        acquire();
+        slot->next = freeList;
+        freeList = slot;
+        release();
+    }
+
+    void acquire() {
+        while (busy.test_and_set(std::memory_order_acquire)) {}
+    }
+
+    void release() {
+        busy.clear(std::memory_order_release);
+    }
+    // 申请新块并把其中槽位按地址顺序串入空闲链表，使连续追加的节点在内存中相邻
+    void grow() {
+        Slot *slots = static_cast<Slot *>(::operator new(sizeof(Slot) * blockSize));
+        blocks = new Block{blocks, slots};
+        for (size_t i = blockSize; i > 0; i--) {
+            slots[i - 1].next = freeList;
+            freeList = &slots[i - 1];
+        }
+        if (blockSize < MAX_BLOCK) blockSize *= 2;
+    }
+};
+
+#endif // NODEPOOL_H
@@ -0,0 +1,361 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 热点路径的计时与计数，供“程序很慢”时查看各操作的耗时分布
+// Metric 与 Counter 定义为静态对象，构造时登记到全局列表；ScopedTimer 在作用域结束时把耗时记入 Metric
+// 耗时按 2 的幂分桶统计，记录一次只做几次无锁的原子加，不分配内存；关闭后每次计时只剩一次原子读
+// 开启追踪时另把每次计时作为一个事件存入缓冲区，可导出为 Chrome 追踪格式（chrome://tracing、Perfetto）
+namespace profiler {
+
+typedef std::chrono::steady_clock Clock;
+
+constexpr int BUCKETS = 40;				// 第 i 桶统计 [2^i, 2^(i+1)) 纳秒，最后一桶包含更长的耗时
+constexpr size_t TRACE_CAPACITY = 1 << 20;	// 追踪缓冲区至多保存的事件数
+
+struct TraceEvent {
+    const char *name;
+    int64_t start;		// 相对 epoch() 的纳秒数
+    int64_t duration;
+    unsigned thread;
+};
+
+inline std::atomic<bool> &enabledFlag() {
+    static std::atomic<bool> flag(true);
+    return flag;
+}
+
+inline std::atomic<bool> &tracingFlag() {
+    static std::atomic<bool> flag(false);
+    return flag;
+}
+// 计时是否开启，默认开启
+inline bool enabled() {
+    return enabledFlag().load(std::memory_order_relaxed);
+}
+
+inline void setEnabled(bool on) {
+    enabledFlag() = on;
+}
+// 是否在统计之外记录追踪事件，默认关闭
+inline bool tracing() {
+    return tracingFlag().load(std::memory_order_relaxed);
+}
+// 程序开始计时的时刻，追踪事件的时间戳以此为零点
+inline Clock::time_point epoch() {
+    static const Clock::time_point start = Clock::now();
+    return start;
+}
+// 线程的短编号，按首次计时的顺序从 1 开始
+inline unsigned threadNumber() {
+    static std::atomic<unsigned> next(1);
+    thread_local unsigned number = next++;
+    return number;
+}
+
+class Trace {
+public:
+    static Trace &instance() {
+        static Trace trace;
+        return trace;
+    }
+
+    void add(const TraceEvent &event) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (events.size() < TRACE_CAPACITY) {
+            events.push_back(event);
+        } else {
+            dropped++;
+        }
+    }
+
+    std::vector<TraceEvent> take(size_t *lost = nullptr) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (lost) *lost = dropped;
+        return events;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(mutex);
+        events.clear();
+        dropped = 0;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return events.size();
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    size_t dropped = 0;		// 缓冲区已满而丢弃的事件数
+};
+// 开启追踪时清空此前的事件
+inline void setTracing(bool on) {
+    if (on && !tracing()) Trace::instance().clear();
+    tracingFlag() = on;
+}
+
+class Metric;
+class Counter;
+
+// 已登记的 Metric 与 Counter，静态对象析构后不再使用
+struct Registry {
+    std::mutex mutex;
+    std::vector<Metric*> metrics;
+    std::vector<Counter*> counters;
+
+    static Registry &instance() {
+        static Registry registry;
+        return registry;
+    }
+};
+
+// 一项操作的耗时统计
+class Metric {
+public:
+    explicit Metric(const char *name): name(name), count(0), total(0), max(0) {
+        for (auto &bucket : buckets) bucket = 0;
+        epoch();
+        Registry &registry = Registry::instance();
+        std::lock_guard<std::mutex> guard(registry.mutex);
+        registry.metrics.push_back(this);
+    }
+
+    Metric(const Metric &) = delete;
+    Metric &operator =(const Metric &) = delete;
+
+    const char *const name;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> total;	// 总耗时，纳秒
+    std::atomic<uint64_t> max;		// 最长一次的耗时，纳秒
+    std::atomic<uint64_t> buckets[BUCKETS];
+
+    void record(uint64_t ns) {
+        count.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(ns, std::memory_order_relaxed);
+        buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t longest = max.load(std::memory_order_relaxed);
+        while (ns > longest && !max.compare_exchange_weak(longest, ns, std::memory_order_relaxed)) {}
+    }
+    // 由分桶估计第 q 分位的耗时（纳秒）：取所在桶的上界，不超过最大值
+    uint64_t percentile(double q) const {
+        uint64_t n = count.load(std::memory_order_relaxed);
+        if (!n) return 0;
+        uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * n + 0.5)), seen = 0;
+        uint64_t longest = max.load(std::memory_order_relaxed);
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return i + 1 < BUCKETS ? std::min(longest, (uint64_t(2) << i) - 1) : longest;
+        }
+        return longest;
+    }
+
+    void reset() {
+        count = 0;
+        total = 0;
+        max = 0;
+        for (auto &bucket : buckets) bucket = 0;
+    }
+
+    static int bucketOf(uint64_t ns) {
+        int i = 0;
+        while (ns > 1 && i < BUCKETS - 1) {
+            ns >>= 1;
+            i++;
+        }
+        return i;
+    }
+};
+
+// 一项数量的累计值，如读入的记录数、查找命中的结果数
+class Counter {
+public:
+    explicit Counter(const char *name): name(name), value(0) {
+        Registry &registry = Registry::instance();
+        std::lock_guard<std::mutex> guard(registry.mutex);
+        registry.counters.push_back(this);
+    }
+
+    Counter(const Counter &) = delete;
+    Counter &operator =(const Counter &) = delete;
+
+    const char *const name;
+    std::atomic<uint64_t> value;
+
+    void add(uint64_t n = 1) {
+        if (enabled()) value.fetch_add(n, std::memory_order_relaxed);
+    }
+};
+
+// 记入从 start 到现在的耗时，供跨越多次回调、无法用 ScopedTimer 包住的操作使用
+inline void finish(Metric &metric, Clock::time_point start) {
+    if (!enabled()) return;
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    metric.record((uint64_t)ns);
+    if (tracing()) {
+        int64_t offset = std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch()).count();
+        Trace::instance().add({metric.name, offset, ns, threadNumber()});
+    }
+}
+
+// 计时从构造到析构的耗时；构造时计时已关闭则什么也不做
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Metric &metric): metric(enabled() ? &metric : nullptr) {
+        if (this->metric) start = Clock::now();
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator =(const ScopedTimer &) = delete;
+
+    ~ScopedTimer() {
+        if (metric) finish(*metric, start);
+    }
+
+private:
+    Metric *metric;
+    Clock::time_point start;
+};
+
+// 某一时刻的统计结果，供界面显示与导出
+struct MetricStats {
+    std::string name;
+    uint64_t count;
+    uint64_t total;
+    uint64_t max;
+    uint64_t p50, p90, p99;
+    std::vector<uint64_t> buckets;
+};
+
+struct CounterStats {
+    std::string name;
+    uint64_t value;
+};
+// 按名称排序的全部统计
+inline std::vector<MetricStats> metrics() {
+    std::vector<MetricStats> out;
+    Registry &registry = Registry::instance();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    for (Metric *metric : registry.metrics) {
+        MetricStats stats;
+        stats.name = metric->name;
+        stats.count = metric->count.load(std::memory_order_relaxed);
+        stats.total = metric->total.load(std::memory_order_relaxed);
+        stats.max = metric->max.load(std::memory_order_relaxed);
+        stats.p50 = metric->percentile(0.5);
+        stats.p90 = metric->percentile(0.9);
+        stats.p99 = metric->percentile(0.99);
+        for (auto &bucket : metric->buckets) stats.buckets.push_back(bucket.load(std::memory_order_relaxed));
+        out.push_back(std::move(stats));
+    }
+    std::sort(out.begin(), out.end(), [](const MetricStats &a, const MetricStats &b) { return a.name < b.name; });
+    return out;
+}
+
+inline std::vector<CounterStats> counters() {
+    std::vector<CounterStats> out;
+    Registry &registry = Registry::instance();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    for (Counter *counter : registry.counters) {
+        out.push_back({counter->name, counter->value.load(std::memory_order_relaxed)});
+    }
+    std::sort(out.begin(), out.end(), [](const CounterStats &a, const CounterStats &b) { return a.name < b.name; });
+    return out;
+}
+// 清零所有统计与追踪事件
+inline void reset() {
+    {
+        Registry &registry = Registry::instance();
+        std::lock_guard<std::mutex> guard(registry.mutex);
+        for (Metric *metric : registry.metrics) metric->reset();
+        for (Counter *counter : registry.counters) counter->value = 0;
+    }
+    Trace::instance().clear();
+}
+
+inline void writeString(std::ostream &out, const std::string &text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if ((unsigned char)c < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+// 以 JSON 写出全部统计，耗时的单位为纳秒；histogram 的第 i 项为 [2^i, 2^(i+1)) 纳秒内的次数，末尾的空桶省略
+inline void writeJson(std::ostream &out) {
+    out << "{\n  \"metrics\": [";
+    bool first = true;
+    for (const MetricStats &stats : metrics()) {
+        if (!stats.count) continue;
+        out << (first ? "\n" : ",\n") << "    {\"name\": ";
+        first = false;
+        writeString(out, stats.name);
+        out << ", \"count\": " << stats.count << ", \"totalNs\": " << stats.total
+            << ", \"meanNs\": " << stats.total / stats.count
+            << ", \"p50Ns\": " << stats.p50 << ", \"p90Ns\": " << stats.p90 << ", \"p99Ns\": " << stats.p99
+            << ", \"maxNs\": " << stats.max << ", \"histogram\": [";
+        size_t used = stats.buckets.size();
+        while (used && !stats.buckets[used - 1]) used--;
+        for (size_t i = 0; i < used; i++) out << (i ? ", " : "") << stats.buckets[i];
+        out << "]}";
+    }
+    out << (first ? "]" : "\n  ]") << ",\n  \"counters\": {";
+    first = true;
+    for (const CounterStats &stats : counters()) {
+        out << (first ? "\n" : ",\n") << "    ";
+        first = false;
+        writeString(out, stats.name);
+        out << ": " << stats.value;
+    }
+    out << (first ? "}" : "\n  }") << "\n}\n";
+}
+// 以 Chrome 追踪格式写出已记录的事件，时间单位为微秒
+inline void writeTrace(std::ostream &out) {
+    size_t lost;
+    std::vector<TraceEvent> events = Trace::instance().take(&lost);
+    out << "{\"displayTimeUnit\": \"ms\", \"otherData\": {\"droppedEvents\": " << lost << "}, \"traceEvents\": [";
+    bool first = true;
+    for (const TraceEvent &event : events) {
+        out << (first ? "\n" : ",\n") << "{\"name\": ";
+        first = false;
+        writeString(out, event.name);
+        out << ", \"cat\": \"library\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread
+            << ", \"ts\": " << event.start / 1000 << '.' << (event.start % 1000) / 100
+            << ", \"dur\": " << event.duration / 1000 << '.' << (event.duration % 1000) / 100 << '}';
+    }
+    out << "\n]}\n";
+}
+// 写入文件，成功返回 0
+inline int writeJson(const char *fileName) {
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out) return 1;
+    writeJson(out);
+    return out.good() ? 0 : 1;
+}
+
+inline int writeTrace(const char *fileName) {
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out) return 1;
+    writeTrace(out);
+    return out.good() ? 0 : 1;
+}
+
+}
+
+#endif // PROFILER_H
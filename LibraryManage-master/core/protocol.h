@@ -0,0 +1,155 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstdint>
+#include <string>
+
+// 借还服务（LibraryServer）的二进制协议，整数均为小端，按字节拼装，与本机字节序无关
+// 每个请求或响应为一帧：（载荷长度 uint32, 载荷）
+// 请求载荷为（请求编号 uint32, 操作 uint8, 参数…），响应载荷为（请求编号 uint32, 状态 uint8, 结果…），
+// 请求编号由客户端选取并原样返回；客户端可连续发送多个请求而不等待响应，响应按请求的顺序返回
+// 参数与结果中的整数为 int32，字符串为（长度 int32, 字节）
+namespace protocol {
+
+enum Op : uint8_t {
+    LOGIN = 1,			// 用户名, 密码 -> 用户；之后的请求以该用户的身份执行
+    FIND_BOOK,			// 编号 -> 图书
+    FIND_USER,			// 编号 -> 用户（非管理员只能查自己）
+    FUZZY_FIND_BOOK,	// 名称片段, 游标, 至多条数 -> 条数, 图书…, 下一次的游标
+    FUZZY_FIND_USER,	// 同上，仅管理员；游标为记录编号，请求中 -1 表示从头开始，响应中 -1 表示已查找到末尾
+    BORROW,				// 用户编号, 图书编号（非管理员只能为自己借还）
+    RETURN,				// 用户编号, 图书编号
+    ADD_BOOK,			// 名称, 编号, 数量（以下仅管理员）
+    ADD_USER,			// 用户名, 密码, 编号, 类型
+    MODIFY_BOOK,		// 原编号, 名称, 编号, 数量
+    MODIFY_USER,		// 原编号, 用户名, 密码, 编号, 类型
+    DEL_BOOK,			// 编号, 是否强制
+    DEL_USER,			// 编号, 是否强制
+    SAVE				// 保存改动
+};
+
+enum Status : uint8_t {
+    OK = 0,
+    BAD_REQUEST,		// 无法解析的请求
+    NOT_LOGGED_IN,
+    FORBIDDEN,			// 权限不足
+    NOT_FOUND,			// 编号（或游标）对应的记录不存在
+    REJECTED			// 操作未能执行，如编号重复、已借完、仍有未还的借阅
+};
+
+// 结果中的图书为（名称, 编号, 数量, 剩余数量），用户为（用户名, 编号, 类型, 已借阅数量）
+// 模糊查找每次至多检查固定数目的候选，条数可能少于请求的数目甚至为 0；响应的游标不为 -1 时应以其继续查找
+
+const uint32_t MAX_FRAME = 1 << 20;	// 载荷长度上限，超过时服务端断开连接
+const int MAX_PAGE = 1000;			// 模糊查找一次至多返回的条数
+
+// 按小端写入、读出 32 位整数
+inline void storeLE(char *out, uint32_t value) {
+    for (size_t i = 0; i < sizeof(value); i++) out[i] = (char)(value >> (8 * i));
+}
+
+inline uint32_t loadLE(const char *in) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < sizeof(value); i++) value |= (uint32_t)(unsigned char)in[i] << (8 * i);
+    return value;
+}
+
+// 在 buffer 末尾构造一帧，析构或 finish() 时填写长度
+class Frame {
+public:
+    explicit Frame(std::string &buffer): buffer(buffer), start(buffer.size()), finished(false) {
+        buffer.append(sizeof(uint32_t), '\0');
+    }
+
+    ~Frame() {
+        finish();
+    }
+
+    Frame(const Frame &) = delete;
+    Frame &operator =(const Frame &) = delete;
+
+    Frame &put(uint8_t value) {
+        buffer.push_back((char)value);
+        return *this;
+    }
+
+    Frame &put(uint32_t value) {
+        char bytes[sizeof(value)];
+        storeLE(bytes, value);
+        buffer.append(bytes, sizeof(bytes));
+        return *this;
+    }
+
+    Frame &put(int32_t value) {
+        return put((uint32_t)value);
+    }
+
+    Frame &put(const std::string &value) {
+        put((int32_t)value.size());
+        buffer.append(value);
+        return *this;
+    }
+
+    void finish() {
+        if (finished) return;
+        storeLE(&buffer[start], (uint32_t)(buffer.size() - start - sizeof(uint32_t)));
+        finished = true;
+    }
+
+private:
+    std::string &buffer;
+    size_t start;		// 长度字段在 buffer 中的位置
+    bool finished;
+};
+
+// 读取一帧的载荷，越界时返回 false
+class Reader {
+public:
+    Reader(const char *data, size_t size): cur(data), end(data + size) {}
+
+    bool get(uint8_t &value) {
+        if (cur == end) return false;
+        value = (uint8_t)*cur++;
+        return true;
+    }
+
+    bool get(uint32_t &value) {
+        if ((size_t)(end - cur) < sizeof(value)) return false;
+        value = loadLE(cur);
+        cur += sizeof(value);
+        return true;
+    }
+
+    bool get(int32_t &value) {
+        uint32_t raw;
+        if (!get(raw)) return false;
+        value = (int32_t)raw;
+        return true;
+    }
+
+    bool get(std::string &value) {
+        int32_t length;
+        if (!get(length) || length < 0 || (size_t)(end - cur) < (size_t)length) return false;
+        value.assign(cur, length);
+        cur += length;
+        return true;
+    }
+
+private:
+    const char *cur;
+    const char *end;
+};
+
+// 从 data 开头取出一帧完整的载荷：成功返回帧的总长度，数据不足返回 0，长度超过上限返回 -1
+inline long long nextFrame(const char *data, size_t size, const char *&payload, uint32_t &length) {
+    if (size < sizeof(uint32_t)) return 0;
+    length = loadLE(data);
+    if (length > MAX_FRAME) return -1;
+    if (size - sizeof(uint32_t) < length) return 0;
+    payload = data + sizeof(uint32_t);
+    return (long long)(sizeof(uint32_t) + length);
+}
+
+}
+
+#endif // PROTOCOL_H
@@ -0,0 +1,79 @@
+#ifndef RWLOCK_H
+#define RWLOCK_H
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 可重入的读写锁，满足 SharedMutex 的要求，可配合 std::shared_lock / std::unique_lock 使用
+// 同一线程持有写锁时再加读锁或写锁、持有读锁时再加读锁都直接通过，因此加锁的方法之间可以互相调用，
+// 监听者也可在收到通知时查询数据；持有读锁时不能再加写锁（会死锁）
+// 写优先：有线程等待写锁时，新来的读者（不含已持有读锁的线程）在 gate 处等待，读操作再密集也不会饿死借还
+class RWLock {
+public:
+    RWLock(): depth(0), waitingWriters(0) {}
+
+    RWLock(const RWLock &) = delete;
+    RWLock &operator =(const RWLock &) = delete;
+
+    void lock() {
+        if (ownsWrite()) {
+            depth++;
+            return;
+        }
+        waitingWriters++;
+        gate.lock();
+        mutex.lock();
+        gate.unlock();
+        waitingWriters--;
+        writer = std::this_thread::get_id();
+        depth = 1;
+    }
+
+    void unlock() {
+        if (--depth) return;
+        writer = std::thread::id();
+        mutex.unlock();
+    }
+
+    void lock_shared() {
+        if (ownsWrite()) return;
+        int &reads = readDepth();
+        if (reads++) return;
+        if (waitingWriters) {
+            std::lock_guard<std::mutex> wait(gate);	// 让等待中的写者先拿到锁
+        }
+        mutex.lock_shared();
+    }
+
+    void unlock_shared() {
+        if (ownsWrite()) return;
+        if (--readDepth() == 0) mutex.unlock_shared();
+    }
+    // 当前线程是否持有写锁
+    bool ownsWrite() const {
+        return writer == std::this_thread::get_id();
+    }
+
+private:
+    std::shared_mutex mutex;
+    std::mutex gate;						// 等待写锁的线程持有，挡住新来的读者
+    std::atomic<std::thread::id> writer;	// 持有写锁的线程
+    int depth;								// 写锁的重入次数，只由持有写锁的线程访问
+    std::atomic<int> waitingWriters;
+
+    // 当前线程对本锁的读锁重入次数
+    int &readDepth() {
+        thread_local std::vector<std::pair<const RWLock *, int>> held;
+        for (auto &entry : held) {
+            if (entry.first == this) return entry.second;
+        }
+        held.emplace_back(this, 0);
+        return held.back().second;
+    }
+};
+
+#endif // RWLOCK_H
@@ -0,0 +1,130 @@
+#ifndef SAVEJOB_H
+#define SAVEJOB_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "csvreader.h"
+#include "csvwriter.h"
+#include "snapshot.h"
+
+// 一次保存的全部内容，在数据所在线程准备好后即与链表无关，可交给任意线程写入
+// 未修改的行只记录其在原文件中的位置，写入时从原文件复制；修改过的行在准备时生成文本
+class SaveJob {
+public:
+    struct Line {
+        const void *node;	// 对应的链表节点，仅用于写入后比对，不解引用
+        uint64_t offset;	// 写入前：在原文件或 text 中的位置；写入后：在新文件中的位置
+        uint64_t length;	// 行长度（不含换行）
+        bool copied;		// 是否从原文件复制
+    };
+
+    struct File {
+        std::string fileName;
+        bool current = false;		// 是否为当前数据文件，写入后需更新各行位置
+        bool skip = true;			// 内容没有改动，无需写入
+        snapshot::FileStamp sourceStamp = {};	// 准备时原文件的大小与修改时间
+        std::string text;			// 修改过的行
+        std::vector<Line> lines;
+        int state = 0;				// 写入结果，0 为成功
+
+        // 追加一行生成的文本
+        void addText(const void *node, std::string_view line) {
+            lines.push_back(Line{node, text.size(), line.size(), false});
+            text.append(line.data(), line.size());
+        }
+        // 追加一行从原文件复制的内容
+        void addCopy(const void *node, uint64_t offset, uint64_t length) {
+            lines.push_back(Line{node, offset, length, true});
+        }
+    };
+
+    File book;
+    File user;
+    char divide = ',';
+    int generation = 0;			// 准备时数据的读取代数，完成时不一致说明期间重新读取了数据
+    uint64_t journalMark = 0;	// 准备时日志的长度，其后的记录不在本次保存的内容中
+    bool writesSnapshot = false;	// 两个文件写完后是否接着写入快照
+    snapshot::Tables tables;	// 准备时生成的快照内容，重写过的文件的行位置在写入后补上
+    int snapshotState = 0;		// 快照写入结果，失败不影响保存本身
+
+    SaveJob(): written(0) {}
+
+    SaveJob(const SaveJob &) = delete;
+    SaveJob &operator =(const SaveJob &) = delete;
+
+    // 写入两个文件，可在工作线程中调用；成功返回 0
+    int run() {
+        book.state = writeFile(book);
+        user.state = writeFile(user);
+        if (book.state || user.state) return 1;
+        if (writesSnapshot) snapshotState = writeSnapshot();
+        return 0;
+    }
+    // 已完成的百分比
+    int progress() const {
+        size_t total = (book.skip ? 0 : book.lines.size()) + (user.skip ? 0 : user.lines.size());
+        return total ? (int)(written * 100 / total) : 100;
+    }
+
+private:
+    std::atomic<size_t> written;	// 已写入的行数
+
+    int writeFile(File &file) {
+        if (file.skip) return 0;
+        MappedFile source;
+        bool needSource = false;
+        for (const Line &line : file.lines) {
+            if (line.copied) {
+                needSource = true;
+                break;
+            }
+        }
+        if (needSource) {
+            snapshot::FileStamp now;
+            // 原文件在准备之后被其他程序改动，引用的行已不可靠
+            if (!snapshot::stamp(file.fileName.c_str(), now) || !(now == file.sourceStamp)
+                    || !source.open(file.fileName.c_str())) {
+                return 1;
+            }
+        }
+        CsvWriter output(file.fileName.c_str(), divide);
+        if (!output.isOpen()) return 1;
+        for (Line &line : file.lines) {
+            uint64_t offset = output.offset();
+            if (line.copied) {
+                if (line.offset > source.size() || line.length > source.size() - line.offset) return 1;
+                output.write(std::string_view(source.data() + line.offset, line.length));
+            } else {
+                output.write(std::string_view(file.text.data() + line.offset, line.length));
+            }
+            output.endLine();
+            line.offset = offset;
+            line.copied = false;
+            written++;
+        }
+        source.close();
+        return output.commit() ? 0 : 1;
+    }
+    // 快照的记录与文件的行同为链表顺序，重写过的文件按新位置更新
+    int writeSnapshot() {
+        if (!book.skip && book.lines.size() == tables.books.size()) {
+            for (size_t i = 0; i < book.lines.size(); i++) {
+                tables.books[i].lineOffset = book.lines[i].offset;
+                tables.books[i].lineLength = (uint32_t)book.lines[i].length;
+            }
+        }
+        if (!user.skip && user.lines.size() == tables.users.size()) {
+            for (size_t i = 0; i < user.lines.size(); i++) {
+                tables.users[i].lineOffset = user.lines[i].offset;
+                tables.users[i].lineLength = (uint32_t)user.lines[i].length;
+            }
+        }
+        return tables.write(snapshot::pathFor(book.fileName.c_str()), user.fileName.c_str(), book.fileName.c_str(),
+                            divide);
+    }
+};
+
+#endif // SAVEJOB_H
@@ -0,0 +1,73 @@
+#ifndef SEARCHJOB_H
+#define SEARCHJOB_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "librarydata.h"
+
+// 一次分页查找，可在任意线程中运行：结果分批交给 deliver，可随时取消
+// 每批在 Library 的读锁下至多检查 BATCH_BUDGET 个候选，其他线程的修改至多等待一批；
+// 两批之间若有记录被删除，游标可能已失效，查找随即停止并以 stale 告知发起方重新查找
+template<class T> class SearchJob {
+public:
+    // 在运行查找的线程中调用；done 表示这是最后一批，stale 表示因游标失效而中止
+    typedef std::function<void(std::vector<Node<T>*> &batch, bool done, bool stale)> Deliver;
+
+    static constexpr size_t BATCH_BUDGET = 4096;	// 每批至多检查的候选数
+
+    SearchJob(Library &library, std::string query, Node<T> *from, bool forward, size_t limit, Deliver deliver):
+        library(library), query(std::move(query)), from(from), forward(forward), limit(limit),
+        deliver(std::move(deliver)), removals(library.removals()), cancelled(false) {}
+
+    SearchJob(const SearchJob &) = delete;
+    SearchJob &operator =(const SearchJob &) = delete;
+
+    void run() {
+        Node<T> *cursor = from;
+        size_t found = 0;
+        while (!cancelled) {
+            std::vector<Node<T>*> batch;
+            bool done, stale = false;
+            {
+                auto lock = library.readLock();
+                if (library.removals() != removals) {
+                    stale = done = true;
+                } else {
+                    cursor = find(cursor, limit - found, batch);
+                    found += batch.size();
+                    done = !cursor || found >= limit;
+                }
+            }
+            // 没有结果的中间批次不必通知
+            if (done || !batch.empty()) deliver(batch, done, stale);
+            if (done) return;
+        }
+    }
+    // 停止查找，已在运行的一批完成后生效
+    void cancel() {
+        cancelled = true;
+    }
+
+private:
+    Library &library;
+    std::string query;
+    Node<T> *from;			// 起始游标，为空时从链表一端开始
+    bool forward;
+    size_t limit;			// 至多取得的结果数
+    Deliver deliver;
+    uint64_t removals;		// 开始时 Library 已删除的记录数
+    std::atomic<bool> cancelled;
+
+    Node<T>* find(Node<T> *cursor, size_t want, std::vector<Node<T>*> &batch) {
+        if constexpr (std::is_same<T, BookInfo>::value) {
+            return library.fuzzyFindBook(query, cursor, forward, want, batch, BATCH_BUDGET);
+        } else {
+            return library.fuzzyFindUser(query, cursor, forward, want, batch, BATCH_BUDGET);
+        }
+    }
+};
+
+#endif // SEARCHJOB_H
@@ -0,0 +1,135 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// 二进制快照（.lbs）文件格式
+// 依次为：文件头、图书记录表、用户记录表、借阅表、读者顺序表、字符串堆
+// 记录均为定长，字符串以（偏移, 长度）引用字符串堆；借阅表按用户 books 链表的顺序排列，
+// 读者顺序表给出各图书 readers 链表中借阅记录的顺序（借阅表下标）
+// 快照记录了写入时两个 csv 文件的大小、修改时间与分隔符，任一不一致即视为过期，改为读取 csv
+namespace snapshot {
+
+const char MAGIC[4] = {'L', 'B', 'S', '1'};
+const uint32_t VERSION = 3;
+const uint32_t ENDIAN_MARK = 0x01020304;	// 用于识别字节序不同的机器写出的快照
+
+// 数据文件的大小与修改时间
+struct FileStamp {
+    uint64_t size;
+    int64_t mtime;
+
+    bool operator ==(const FileStamp &other) const {
+        return size == other.size && mtime == other.mtime;
+    }
+};
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t headerSize;
+    uint32_t divide;		// csv 文件的分隔符，与读取时所用的不同则快照无效
+    uint32_t reserved;
+    FileStamp userFile;
+    FileStamp bookFile;
+    uint64_t bookCount;
+    uint64_t userCount;
+    uint64_t loanCount;
+    uint64_t heapSize;
+};
+
+// lineOffset/lineLength 为该记录在 csv 文件中所占的字节范围，供增量保存复制未修改的行
+struct BookRecord {
+    uint64_t nameOffset;
+    uint64_t lineOffset;
+    uint32_t nameLength;
+    uint32_t lineLength;
+    int32_t identifier;
+    int32_t quantity;
+};
+
+struct UserRecord {
+    uint64_t nameOffset;
+    uint64_t passwordOffset;
+    uint64_t lineOffset;
+    uint32_t nameLength;
+    uint32_t passwordLength;
+    uint32_t lineLength;
+    int32_t identifier;
+    int32_t type;
+    uint32_t reserved;
+};
+
+struct LoanRecord {
+    uint32_t user;		// 用户记录表下标
+    uint32_t book;		// 图书记录表下标
+};
+
+// 取文件的大小与修改时间，文件不存在时返回 false
+inline bool stamp(const char *fileName, FileStamp &out) {
+    std::error_code ec;
+    std::filesystem::path path(fileName);
+    out.size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    out.mtime = (int64_t)time.time_since_epoch().count();
+    return true;
+}
+// 判断快照文件是否存在且与给定的文件状态及分隔符一致
+inline bool matches(const std::string &fileName, const FileStamp &userStamp, const FileStamp &bookStamp,
+                    char divide) {
+    Header header;
+    std::ifstream input(fileName, std::ios::binary);
+    if (!input.read((char *)&header, sizeof(header))) return false;
+    return !memcmp(header.magic, MAGIC, sizeof(header.magic)) && header.version == VERSION
+            && header.divide == (unsigned char)divide && header.userFile == userStamp && header.bookFile == bookStamp;
+}
+// 一份快照的全部内容，由数据所在线程生成后即与链表无关，可在任意线程写入
+struct Tables {
+    std::vector<BookRecord> books;
+    std::vector<UserRecord> users;
+    std::vector<LoanRecord> loans;
+    std::vector<uint32_t> readerOrder;
+    std::string heap;
+
+    // 以两个 csv 文件此时的大小与修改时间及其分隔符为基准写入 fileName，须在 csv 写完之后调用；成功返回 0
+    int write(const std::string &fileName, const char *userFile, const char *bookFile, char divide) const {
+        Header header = {};
+        memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.byteOrder = ENDIAN_MARK;
+        header.headerSize = sizeof(header);
+        header.divide = (unsigned char)divide;
+        if (!stamp(userFile, header.userFile) || !stamp(bookFile, header.bookFile)) return 1;
+        header.bookCount = books.size();
+        header.userCount = users.size();
+        header.loanCount = loans.size();
+        header.heapSize = heap.size();
+        std::ofstream output(fileName, std::ios::binary);
+        if (!output) return 1;
+        output.write((const char *)&header, sizeof(header));
+        output.write((const char *)books.data(), books.size() * sizeof(BookRecord));
+        output.write((const char *)users.data(), users.size() * sizeof(UserRecord));
+        output.write((const char *)loans.data(), loans.size() * sizeof(LoanRecord));
+        output.write((const char *)readerOrder.data(), readerOrder.size() * sizeof(uint32_t));
+        output.write(heap.data(), heap.size());
+        output.close();
+        return output ? 0 : 1;
+    }
+};
+// 快照文件路径：与图书文件同目录同名，扩展名为 .lbs
+inline std::string pathFor(const char *bookFile) {
+    return std::filesystem::path(bookFile).replace_extension(".lbs").string();
+}
+
+}
+
+#endif // SNAPSHOT_H
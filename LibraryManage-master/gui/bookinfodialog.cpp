@@ -6,12 +6,19 @@
 #include <QMessageBox>
 #include <QIntValidator>
 
+namespace {
+
+profiler::Metric tableMetric("BookInfoDialog::displayTable");
+
+}
+
 BookInfoDialog::BookInfoDialog(QWidget *parent, int _bookID) :
     QDialog(parent),
     ui(new Ui::BookInfoDialog) {
     ui->setupUi(this);
 
-    userModel = new QStandardItemModel();
+    userModel = new UserTableModel(lib, this);
+    userModel->setHeaderData(2, Qt::Horizontal, tr("已借阅总数"));
 
     ui->idEdit->setValidator(new QIntValidator(0, INT_MAX, this));
 
@@ -56,16 +63,10 @@ BookInfoDialog::~BookInfoDialog() {
 void BookInfoDialog::receiveData(QString data) {
     auto user = lib.findUser(data.toInt());
     lib.borrowBook(user, book);
-    displayTable();
+    updateSummary();
 }
 
 void BookInfoDialog::initUserTable() {
-    disableButton();
-    userModel->clear();
-    userModel->setColumnCount(3);
-    userModel->setHeaderData(0, Qt::Horizontal, tr("用户名"));
-    userModel->setHeaderData(1, Qt::Horizontal, tr("编号"));
-    userModel->setHeaderData(2, Qt::Horizontal, tr("已借阅总数"));
     ui->tableView->setModel(userModel);
     ui->tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     ui->tableView->horizontalHeader()->setSectionResizeMode(2, QHeaderView::Fixed);
@@ -75,20 +76,15 @@ void BookInfoDialog::initUserTable() {
 }
 
 void BookInfoDialog::displayTable() {
+    profiler::ScopedTimer timer(tableMetric);
     initUserTable();
-    ui->numLabel->setText(tr("共借出 ") + QString::number(book->elem.readers.size()) + tr(" 本"));
-    for (auto p = book->elem.readers.begin(); p != book->elem.readers.end(); p = p->next) {
-        appendSingleUser(p->elem);
-    }
+    userModel->showLoans(book);
+    updateSummary();
 }
-
-void BookInfoDialog::appendSingleUser(Node<UserInfo>* p) {
-    if (!p) return;
-    QList<QStandardItem*> list;
-    list << new QStandardItem(p->elem.name.data())
-         << new QStandardItem(std::to_string(p->elem.identifier).data())
-         << new QStandardItem(std::to_string(p->elem.books.size()).data());
-    userModel->appendRow(list);
+// 借还之后表格已随通知更新，只需刷新借出数量与按钮
+void BookInfoDialog::updateSummary() {
+    disableButton();
+    ui->numLabel->setText(tr("共借出 ") + QString::number(book->elem.readers.size()) + tr(" 本"));
 }
 
 void BookInfoDialog::disableButton() {
@@ -105,7 +101,7 @@ void BookInfoDialog::disableButton() {
     if (loginUserID == -1) {
         return;
     }
-    if (lib.findUser(loginUserID)->elem.books.find(book)) {
+    if (lib.hasBorrowed(lib.findUser(loginUserID), book)) {
         ui->returnThisButton->setDisabled(false);
     } else {
         ui->returnThisButton->setDisabled(true);
@@ -120,7 +116,7 @@ void BookInfoDialog::updateButton(int bookID, int userID) {
         ui->borrowButton->setDisabled(false);
     }
 
-    if (lib.findUser(userID)->elem.books.find(book)) {
+    if (lib.hasBorrowed(lib.findUser(userID), book)) {
         ui->returnButton->setDisabled(false);
     } else {
         ui->returnButton->setDisabled(true);
@@ -131,7 +127,7 @@ void BookInfoDialog::on_returnButton_clicked() {
     if (!book) return;
     int userID = getSelection();
     lib.returnBook(userID, book->elem.identifier);
-    displayTable();
+    updateSummary();
 }
 
 int BookInfoDialog::getSelection() {
@@ -155,9 +151,9 @@ void BookInfoDialog::updateBookInfo() {
     int    id   = ui->idEdit->text().toInt();
     int    num  = ui->numEdit->value();
     if (book) {
-        book->elem.name = name;
-        book->elem.identifier = id;
-        book->elem.quantity   = num;
+        lib.modifyName(book, name);
+        lib.modifyID(book, id);
+        lib.setQuantity(book, num);
     } else {
         book = lib.add(BookInfo(name, id, num));
     }
@@ -221,18 +217,18 @@ void BookInfoDialog::on_tableView_doubleClicked(const QModelIndex &index) {
     int userID = getSelection(index);
     UserInfoDialog userDialog(this, userID);
     userDialog.exec();
-    displayTable();
+    updateSummary();
 }
 
 void BookInfoDialog::on_borrowThisButton_clicked() {
     auto user = lib.findUser(loginUserID);
     lib.borrowBook(user, book);
-    displayTable();
+    updateSummary();
 }
 
 void BookInfoDialog::on_returnThisButton_clicked() {
     auto user = lib.findUser(loginUserID);
     lib.returnBook(user, book);
-    displayTable();
+    updateSummary();
 }
 
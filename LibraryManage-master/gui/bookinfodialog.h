@@ -2,8 +2,8 @@
 #define BOOKINFODIALOG_H
 
 #include "librarydata.h"
+#include "recordmodel.h"
 #include <QDialog>
-#include <QStandardItemModel>
 
 namespace Ui {
 class BookInfoDialog;
@@ -40,18 +40,18 @@ private slots:
 
 private:
     Ui::BookInfoDialog *ui;
-    QStandardItemModel* userModel;
+    UserTableModel* userModel;
     Node<BookInfo>* book;
 
     void initUserTable();
 
     void displayTable();
 
-    void disableButton();
+    void updateSummary();
 
-    void displayUserList(List<Node<UserInfo>*>);
+    void disableButton();
 
-    void appendSingleUser(Node<UserInfo>*);
+    void displayUserList(const List<Node<UserInfo>*> &);
 
     void updateButton(int, int);
 
@@ -0,0 +1,117 @@
+#include "diagnosticsdialog.h"
+#include "ui_diagnosticsdialog.h"
+
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QMessageBox>
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::DiagnosticsDialog)
+{
+    ui->setupUi(this);
+
+    ui->metricTable->setColumnCount(8);
+    ui->metricTable->setHorizontalHeaderLabels({tr("操作"), tr("次数"), tr("总计"), tr("平均"),
+                                                tr("P50"), tr("P90"), tr("P99"), tr("最长")});
+    ui->metricTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    ui->metricTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    ui->counterTable->setColumnCount(2);
+    ui->counterTable->setHorizontalHeaderLabels({tr("计数"), tr("累计")});
+    ui->counterTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    for (QTableWidget *table : {ui->metricTable, ui->counterTable}) {
+        table->verticalHeader()->setVisible(false);
+        table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        table->setSelectionBehavior(QAbstractItemView::SelectRows);
+        table->setAlternatingRowColors(true);
+    }
+    ui->traceCheckBox->setChecked(profiler::tracing());
+
+    displayStats();
+}
+
+DiagnosticsDialog::~DiagnosticsDialog()
+{
+    delete ui;
+}
+
+// 按量级选择单位显示纳秒数
+QString DiagnosticsDialog::formatTime(uint64_t ns)
+{
+    if (ns < 1000) return QString::number(ns) + " ns";
+    if (ns < 1000000) return QString::number(ns / 1e3, 'f', 1) + " µs";
+    if (ns < 1000000000) return QString::number(ns / 1e6, 'f', 2) + " ms";
+    return QString::number(ns / 1e9, 'f', 2) + " s";
+}
+
+void DiagnosticsDialog::displayStats()
+{
+    // 只列出至少记录过一次的操作，分位数由分桶估计，精度为 2 倍以内
+    std::vector<profiler::MetricStats> metrics = profiler::metrics();
+    ui->metricTable->setRowCount(0);
+    for (const profiler::MetricStats &stats : metrics) {
+        if (!stats.count) continue;
+        int row = ui->metricTable->rowCount();
+        ui->metricTable->insertRow(row);
+        QStringList cells = {QString::fromStdString(stats.name), QString::number(stats.count),
+                             formatTime(stats.total), formatTime(stats.total / stats.count),
+                             formatTime(stats.p50), formatTime(stats.p90), formatTime(stats.p99),
+                             formatTime(stats.max)};
+        for (int column = 0; column < cells.size(); column++) {
+            auto *item = new QTableWidgetItem(cells[column]);
+            if (column) item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            ui->metricTable->setItem(row, column, item);
+        }
+    }
+
+    std::vector<profiler::CounterStats> counters = profiler::counters();
+    ui->counterTable->setRowCount((int)counters.size());
+    for (int row = 0; row < (int)counters.size(); row++) {
+        ui->counterTable->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(counters[row].name)));
+        auto *item = new QTableWidgetItem(QString::number(counters[row].value));
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        ui->counterTable->setItem(row, 1, item);
+    }
+}
+
+void DiagnosticsDialog::on_refreshButton_clicked()
+{
+    displayStats();
+}
+
+void DiagnosticsDialog::on_resetButton_clicked()
+{
+    profiler::reset();
+    displayStats();
+}
+
+void DiagnosticsDialog::on_traceCheckBox_toggled(bool checked)
+{
+    // 开启时清空此前的追踪事件；关闭后已记录的事件仍可导出
+    profiler::setTracing(checked);
+}
+
+void DiagnosticsDialog::on_exportJsonButton_clicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,
+                tr("导出性能统计"), "./profile.json", tr("JSON 文件 (*.json)"));
+    if (fileName.isEmpty()) return;
+    if (profiler::writeJson(fileName.toLocal8Bit())) {
+        QMessageBox::warning(this, tr("错误"), tr("写入文件失败。"), QMessageBox::Ok);
+    }
+}
+
+void DiagnosticsDialog::on_exportTraceButton_clicked()
+{
+    if (!profiler::Trace::instance().size()) {
+        QMessageBox::information(this, tr("信息"), tr("尚未记录追踪事件。<br>请勾选“记录追踪”后重现缓慢的操作。"),
+                                 QMessageBox::Ok);
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this,
+                tr("导出追踪"), "./trace.json", tr("Chrome 追踪文件 (*.json)"));
+    if (fileName.isEmpty()) return;
+    if (profiler::writeTrace(fileName.toLocal8Bit())) {
+        QMessageBox::warning(this, tr("错误"), tr("写入文件失败。"), QMessageBox::Ok);
+    }
+}
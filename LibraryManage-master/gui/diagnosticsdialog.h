@@ -0,0 +1,39 @@
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include "profiler.h"
+#include <QDialog>
+
+namespace Ui {
+class DiagnosticsDialog;
+}
+
+// 查看各热点操作的耗时统计，可清零、开关追踪，并导出为 JSON 或 Chrome 追踪格式
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsDialog(QWidget *parent = nullptr);
+    ~DiagnosticsDialog();
+
+private slots:
+    void on_refreshButton_clicked();
+
+    void on_resetButton_clicked();
+
+    void on_traceCheckBox_toggled(bool);
+
+    void on_exportJsonButton_clicked();
+
+    void on_exportTraceButton_clicked();
+
+private:
+    Ui::DiagnosticsDialog *ui;
+
+    void displayStats();
+
+    static QString formatTime(uint64_t);
+};
+
+#endif // DIAGNOSTICSDIALOG_H
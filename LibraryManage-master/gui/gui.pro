@@ -0,0 +1,56 @@
+QT       += core gui concurrent
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = LibraryManage
+CONFIG += c++17
+
+include(../core/core.pri)
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    bookinfodialog.cpp \
+    diagnosticsdialog.cpp \
+    logindialog.cpp \
+    main.cpp \
+    librarymain.cpp \
+    passworddialog.cpp \
+    selectdialog.cpp \
+    userinfodialog.cpp
+
+HEADERS += \
+    bookinfodialog.h \
+    diagnosticsdialog.h \
+    librarymain.h \
+    logindialog.h \
+    passworddialog.h \
+    recordmodel.h \
+    selectdialog.h \
+    userinfodialog.h
+
+FORMS += \
+    bookinfodialog.ui \
+    diagnosticsdialog.ui \
+    librarymain.ui \
+    logindialog.ui \
+    passworddialog.ui \
+    selectdialog.ui \
+    userinfodialog.ui
+
+TRANSLATIONS += \
+    LibraryManage_zh_CN.ts
+CONFIG += lrelease
+CONFIG += embed_translations
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+DISTFILES += \
+    book.ico
+
+RC_ICONS = book.ico
@@ -2,30 +2,57 @@
 #include "ui_librarymain.h"
 #include "bookinfodialog.h"
 #include "userinfodialog.h"
+#include "diagnosticsdialog.h"
 
 #include <QTableView>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QtConcurrent>
+
+namespace {
+
+profiler::Metric bookDataMetric("LibraryMain::displayBookData");
+profiler::Metric userDataMetric("LibraryMain::displayUserData");
+
+}
 
 LibraryMain::LibraryMain(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::LibraryMain)
+    , recorder(lib)
 {
     ui->setupUi(this);
 
-    // 隐藏翻页按钮和图书/用户切换按钮
-    ui->pageUpButton->setHidden(true);
-    ui->pageDnButton->setHidden(true);
+    // 默认为图书模式，禁用图书切换按钮
     ui->bookSwitchButton->setDisabled(true);
 
-    // 初始化图书和用户的数据模型
-    bookModel = new QStandardItemModel();
-    userModel = new QStandardItemModel();
+    // 初始化图书和用户的数据模型，翻页或结果变化时刷新翻页按钮与状态栏中的位置
+    bookModel = new BookTableModel(lib, this);
+    userModel = new UserTableModel(lib, this);
+    pageLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(pageLabel);
+    connect(bookModel, &RecordModelBase::pageChanged, this, &LibraryMain::updatePageStatus);
+    connect(userModel, &RecordModelBase::pageChanged, this, &LibraryMain::updatePageStatus);
+    bookModel->setBackgroundSearch(true);
+    userModel->setBackgroundSearch(true);
 
     // 设置表格选择行为和选择模式
     ui->tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
     ui->tableView->setSelectionMode(QAbstractItemView::SingleSelection);
 
+    // 后台保存完成与进度刷新，以及每分钟一次的自动保存
+    connect(&saveWatcher, &QFutureWatcher<int>::finished, this, &LibraryMain::onSaveFinished);
+    connect(&saveProgressTimer, &QTimer::timeout, this, &LibraryMain::updateSaveProgress);
+    connect(&autosaveTimer, &QTimer::timeout, this, &LibraryMain::autosave);
+    saveProgressTimer.setInterval(100);
+    autosaveTimer.start(60 * 1000);
+
+    // 边输入边查找：输入停顿 250 毫秒后查找，查找在工作线程中进行，新的输入会取消尚未完成的查找
+    searchTimer.setSingleShot(true);
+    searchTimer.setInterval(250);
+    connect(ui->searchBox, &QLineEdit::textChanged, &searchTimer, qOverload<>(&QTimer::start));
+    connect(&searchTimer, &QTimer::timeout, this, &LibraryMain::on_searchButton_clicked);
+
     // 显示图书数据
     displayBookData();
 
@@ -55,14 +82,17 @@ void LibraryMain::closeEvent(QCloseEvent *event)
                                    QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel);
     switch (ret) {
     case QMessageBox::Save:
-        // 保存图书和用户数据到文件
-        if (lib.writeBook(lib.bookPath) || lib.writeUser(lib.userPath)) {
+        // 等待后台保存结束，再保存其后的改动（日志过大时完整写入图书和用户数据文件）
+        waitForSave();
+        if (lib.save()) {
             QMessageBox::warning(this, tr("错误"), tr("写入文件失败。"), QMessageBox::Ok);
             return;
         }
         event->accept();
         break;
     case QMessageBox::Discard:
+        waitForSave();
+        lib.discard();
         event->accept();
         break;
     case QMessageBox::Cancel:
@@ -74,14 +104,8 @@ void LibraryMain::closeEvent(QCloseEvent *event)
 
 void LibraryMain::initBookTable()
 {
-    // 禁用按钮并清空图书模型
+    // 禁用按钮并切换到图书模型
     disableButton();
-    bookModel->clear();
-    bookModel->setColumnCount(4);
-    bookModel->setHeaderData(0, Qt::Horizontal, tr("名称"));
-    bookModel->setHeaderData(1, Qt::Horizontal, tr("编号"));
-    bookModel->setHeaderData(2, Qt::Horizontal, tr("总数量"));
-    bookModel->setHeaderData(3, Qt::Horizontal, tr("剩余数量"));
     ui->tableView->setModel(bookModel);
     ui->tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
 
@@ -102,13 +126,8 @@ void LibraryMain::initBookTable()
 
 void LibraryMain::initUserTable()
 {
-    // 禁用按钮并清空用户模型
+    // 禁用按钮并切换到用户模型
     disableButton();
-    userModel->clear();
-    userModel->setColumnCount(3);
-    userModel->setHeaderData(0, Qt::Horizontal, tr("用户名"));
-    userModel->setHeaderData(1, Qt::Horizontal, tr("编号"));
-    userModel->setHeaderData(2, Qt::Horizontal, tr("已借阅数量"));
     ui->tableView->setModel(userModel);
     ui->tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     ui->tableView->horizontalHeader()->setSectionResizeMode(2, QHeaderView::Fixed);
@@ -120,19 +139,17 @@ void LibraryMain::initUserTable()
 void LibraryMain::displayBookData()
 {
     // 初始化图书表格并显示所有图书数据
+    profiler::ScopedTimer timer(bookDataMetric);
     initBookTable();
-    for (auto p = lib.books.begin(); p != lib.books.end(); p = p->next) {
-        appendSingleBook(p);
-    }
+    bookModel->showAll();
 }
 
 void LibraryMain::displayUserData()
 {
     // 初始化用户表格并显示所有用户数据
+    profiler::ScopedTimer timer(userDataMetric);
     initUserTable();
-    for (auto p = lib.users.begin(); p != lib.users.end(); p = p->next) {
-        appendSingleUser(p);
-    }
+    userModel->showAll();
 }
 
 void LibraryMain::on_bookSwitchButton_clicked()
@@ -163,82 +180,60 @@ void LibraryMain::on_userSwitchButton_clicked()
     ui->searchButton->click();
 }
 
-void LibraryMain::displayBookList(List<Node<BookInfo>*> list)
+void LibraryMain::displayBookSearch(const std::string &name)
 {
-    // 显示指定的图书列表
+    // 分页显示名称包含 name 的图书
     initBookTable();
-    for (auto p = list.begin(); p != list.end(); p = p->next) {
-        appendSingleBook(p->elem);
-    }
+    bookModel->showSearch(name);
 }
 
-void LibraryMain::displayUserList(List<Node<UserInfo>*> list)
+void LibraryMain::displayUserSearch(const std::string &name)
 {
-    // 显示指定的用户列表
+    // 分页显示名称包含 name 的用户
     initUserTable();
-    for (auto p = list.begin(); p != list.end(); p = p->next) {
-        appendSingleUser(p->elem);
-    }
-}
-
-void LibraryMain::appendSingleBook(Node<BookInfo>* p)
-{
-    // 向图书表格添加单个图书条目
-    if (!p) return;
-    QList<QStandardItem*> list;
-    list << new QStandardItem(p->elem.name.data())
-         << new QStandardItem(std::to_string(p->elem.identifier).data())
-         << new QStandardItem(std::to_string(p->elem.quantity).data())
-         << new QStandardItem(std::to_string(p->elem.quantity - p->elem.readers.size()).data());
-    bookModel->appendRow(list);
-}
-
-void LibraryMain::appendSingleUser(Node<UserInfo>* p)
-{
-    // 向用户表格添加单个用户条目
-    if (!p) return;
-    QList<QStandardItem*> list;
-    list << new QStandardItem(p->elem.name.data())
-         << new QStandardItem(std::to_string(p->elem.identifier).data())
-         << new QStandardItem(std::to_string(p->elem.books.size()).data());
-    userModel->appendRow(list);
+    userModel->showSearch(name);
 }
 
 void LibraryMain::displaySingleBook(Node<BookInfo>* p)
 {
     // 显示单个图书详情
     initBookTable();
-    appendSingleBook(p);
+    bookModel->setRows(p ? std::vector<Node<BookInfo>*>{p} : std::vector<Node<BookInfo>*>());
 }
 
 void LibraryMain::displaySingleUser(Node<UserInfo>* p)
 {
     // 显示单个用户详情
     initUserTable();
-    appendSingleUser(p);
+    userModel->setRows(p ? std::vector<Node<UserInfo>*>{p} : std::vector<Node<UserInfo>*>());
 }
 
 void LibraryMain::on_searchButton_clicked()
 {
     // 根据搜索框内容进行图书或用户搜索
+    searchTimer.stop();
     QString query = ui->searchBox->text();
+    // 录制按名称查找与浏览全部记录，按编号查找不录制
+    bool byName = query.isEmpty() || ui->selectNameButton->isChecked();
     if (!ui->bookSwitchButton->isEnabled()) {
+        if (byName) recorder.findBook(query.toStdString());
         if (query.isEmpty()) {
             displayBookData();
             return;
         }
         if (ui->selectNameButton->isChecked()) {
-            displayBookList(lib.fuzzyFindBook(query.toStdString()));
+            displayBookSearch(query.toStdString());
         } else {
             displaySingleBook(lib.findBook(query.toInt()));
         }
     } else {
+        if (byName) recorder.findUser(query.toStdString());
         if (query.isEmpty()) {
             displayUserData();
             return;
         }
         if (ui->selectNameButton->isChecked()) {
-            displayUserList(lib.fuzzyFindUser(query.toStdString()));
+            displayUserSearch(query.toStdString());
         } else {
             displaySingleUser(lib.findUser(query.toInt()));
         }
@@ -269,7 +264,8 @@ void LibraryMain::on_borrowButton_clicked() {
         QMessageBox::information(this, tr("提示"), tr("没有这本书剩余了。"), QMessageBox::Ok);
         return;
     }
-    displayBookData();
+    // 表格已随借阅通知更新，只需刷新按钮状态
+    updateButton(bookID, loginUserID);
     ui->statusbar->showMessage(tr("成功借阅《") + tr(lib.findBook(bookID)->elem.name.data())
                                + tr("》。"), 3000);
 }
@@ -285,12 +281,55 @@ void LibraryMain::on_returnButton_clicked() {
         QMessageBox::information(this, tr("提示"), tr("你没有借阅这本书。"), QMessageBox::Ok);
         return;
     }
-    displayBookData();
+    updateButton(bookID, loginUserID);
     ui->statusbar->showMessage(tr("成功归还《") + tr(lib.findBook(bookID)->elem.name.data())
                                + tr("》。"), 3000);
 }
 
 
+void LibraryMain::on_pageUpButton_clicked() {
+    disableButton();
+    if (!ui->bookSwitchButton->isEnabled()) {
+        bookModel->prevPage();
+    } else {
+        userModel->prevPage();
+    }
+}
+
+void LibraryMain::on_pageDnButton_clicked() {
+    disableButton();
+    if (!ui->bookSwitchButton->isEnabled()) {
+        bookModel->nextPage();
+    } else {
+        userModel->nextPage();
+    }
+}
+
+// 根据当前显示的模型刷新翻页按钮，并在状态栏显示本页的位置
+void LibraryMain::updatePageStatus() {
+    bool showBooks = !ui->bookSwitchButton->isEnabled();
+    bool hasPrev = showBooks ? bookModel->hasPrevPage() : userModel->hasPrevPage();
+    bool hasNext = showBooks ? bookModel->hasNextPage() : userModel->hasNextPage();
+    int first = showBooks ? bookModel->pageFirst() : userModel->pageFirst();
+    int rows = showBooks ? bookModel->rowCount() : userModel->rowCount();
+    int total = showBooks ? bookModel->total() : userModel->total();
+    bool searching = showBooks ? bookModel->isSearching() : userModel->isSearching();
+    // 查找进行中时翻页会取消它，待结果完整后再允许
+    ui->pageUpButton->setEnabled(hasPrev && !searching);
+    ui->pageDnButton->setEnabled(hasNext && !searching);
+    if (searching) {
+        pageLabel->setText(tr("正在查找…"));
+    } else if (!rows) {
+        pageLabel->setText(tr("无记录"));
+    } else if (total < 0) {
+        pageLabel->setText(tr("第 %1 页，第 %2-%3 条").arg(first / BookTableModel::PAGE_SIZE + 1)
+                           .arg(first + 1).arg(first + rows));
+    } else {
+        pageLabel->setText(tr("第 %1 页，第 %2-%3 条，共 %4 条").arg(first / BookTableModel::PAGE_SIZE + 1)
+                           .arg(first + 1).arg(first + rows).arg(total));
+    }
+}
+
 void LibraryMain::on_tableView_clicked(const QModelIndex &index) {
     if (!index.isValid()) {
         return;
@@ -320,7 +359,7 @@ void LibraryMain::updateButton(int bookID, int userID) {
         ui->borrowButton->setDisabled(false);
     }
 
-    if (lib.findUser(userID)->elem.books.find(book)) {
+    if (lib.hasBorrowed(lib.findUser(userID), book)) {
         ui->returnButton->setDisabled(false);
     } else {
         ui->returnButton->setDisabled(true);
@@ -349,7 +388,9 @@ void LibraryMain::on_editButton_clicked() {
         UserInfoDialog userDialog(this, selectedID);
         userDialog.exec();
     }
-    ui->searchButton->click();
+    // 表格已随改动更新，保持当前页，只刷新按钮
+    disableButton();
+    on_tableView_clicked(ui->tableView->currentIndex());
 }
 
 
@@ -366,7 +407,8 @@ void LibraryMain::on_addButton_clicked() {
         delete dialog;
     }
 
-    ui->searchButton->click();
+    disableButton();
+    on_tableView_clicked(ui->tableView->currentIndex());
 }
 
 
@@ -382,14 +424,64 @@ void LibraryMain::on_tableView_doubleClicked() {
 
 
 void LibraryMain::on_writeDataAction_triggered() {
-    bool bookState = lib.writeBook(lib.bookPath);
-    bool userState = lib.writeUser(lib.userPath);
-    if (!bookState || !userState) {
-        QMessageBox::warning(this, tr("错误"), tr("写入文件失败。"), QMessageBox::Ok);
+    saveData();
+}
+
+// 保存数据：日志较小时只需将日志落盘；否则在后台线程写出数据文件，期间仍可继续编辑
+void LibraryMain::saveData() {
+    if (saveJob) {
+        saveAgain = true;
         return;
     }
-    ui->statusbar->showMessage(tr("成功写入文件 ") + tr(lib.bookPath)
-                               + tr(", ") + tr(lib.userPath), 3000);
+    if (!lib.needsRewrite()) {
+        if (lib.save()) {
+            QMessageBox::warning(this, tr("错误"), tr("写入文件失败。"), QMessageBox::Ok);
+            return;
+        }
+        ui->statusbar->showMessage(tr("成功写入文件 ") + tr(lib.bookPath)
+                                   + tr(", ") + tr(lib.userPath), 3000);
+        return;
+    }
+    saveJob = lib.prepareSave(lib.userPath, lib.bookPath);
+    SaveJob *job = saveJob.get();
+    saveWatcher.setFuture(QtConcurrent::run([job]() { return job->run(); }));
+    updateSaveProgress();
+    saveProgressTimer.start();
+}
+
+void LibraryMain::onSaveFinished() {
+    if (!saveJob) return;
+    saveProgressTimer.stop();
+    int ret = lib.finishSave(*saveJob);
+    saveJob.reset();
+    if (ret) {
+        QMessageBox::warning(this, tr("错误"), tr("写入文件失败。"), QMessageBox::Ok);
+    } else {
+        ui->statusbar->showMessage(tr("成功写入文件 ") + tr(lib.bookPath)
+                                   + tr(", ") + tr(lib.userPath), 3000);
+    }
+    if (saveAgain) {
+        saveAgain = false;
+        saveData();
+    }
+}
+
+void LibraryMain::updateSaveProgress() {
+    if (saveJob) {
+        ui->statusbar->showMessage(tr("正在保存... %1%").arg(saveJob->progress()));
+    }
+}
+
+void LibraryMain::autosave() {
+    if (lib.hasUnsavedChanges()) saveData();
+}
+
+// 阻塞等待后台保存结束，退出前调用
+void LibraryMain::waitForSave() {
+    if (!saveJob) return;
+    saveWatcher.waitForFinished();
+    saveAgain = false;
+    onSaveFinished();
 }
 
 
@@ -416,7 +508,7 @@ void LibraryMain::on_importAction_triggered() {
     QString userFile = QFileDialog::getOpenFileName(this,
                 tr("导入用户数据文件"), "./", tr("csv 文件 (*.csv)"));
     if (bookFile.isEmpty() || userFile.isEmpty()) return;
-    if (!lib.read(userFile.toLatin1(), bookFile.toLatin1())) {
+    if (lib.read(userFile.toLatin1(), bookFile.toLatin1())) {
         QMessageBox::warning(this, tr("错误"), tr("读取文件失败。"), QMessageBox::Ok);
         return;
     }
@@ -430,7 +522,7 @@ void LibraryMain::on_exportAction_triggered() {
     QString userFile = QFileDialog::getSaveFileName(this,
                 tr("导出用户数据文件"), "./user.csv", tr("csv 文件 (*.csv)"));
     if (bookFile.isEmpty() || userFile.isEmpty()) return;
-    if (!lib.writeBook(bookFile.toLatin1()) || !lib.writeUser(userFile.toLatin1())) {
+    if (lib.write(userFile.toLatin1(), bookFile.toLatin1())) {
         QMessageBox::warning(this, tr("错误"), tr("写入文件失败。"), QMessageBox::Ok);
         return;
     }
@@ -443,7 +535,7 @@ void LibraryMain::on_readDataAction_triggered() {
         return;
     }
 
-    if (!lib.read(lib.userPath, lib.bookPath)) {
+    if (lib.read(lib.userPath, lib.bookPath)) {
         QMessageBox::warning(this, tr("错误"), tr("读取文件失败。"), QMessageBox::Ok);
         return;
     }
@@ -462,3 +554,30 @@ void LibraryMain::on_aboutAction_triggered() {
 }
 
 
+void LibraryMain::on_diagnosticsAction_triggered() {
+    DiagnosticsDialog dialog(this);
+    dialog.exec();
+}
+
+
+void LibraryMain::on_recordAction_triggered(bool checked) {
+    if (!checked) {
+        size_t count = recorder.size();
+        if (recorder.stop()) {
+            QMessageBox::warning(this, tr("错误"), tr("写入操作记录失败。"), QMessageBox::Ok);
+            return;
+        }
+        ui->statusbar->showMessage(tr("已停止录制，共 ") + QString::number(count) + tr(" 项操作"), 3000);
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this,
+                tr("录制操作"), "./library.trace", tr("操作记录 (*.trace)"));
+    if (fileName.isEmpty() || recorder.start(fileName.toLocal8Bit())) {
+        if (!fileName.isEmpty()) {
+            QMessageBox::warning(this, tr("错误"), tr("无法写入文件。"), QMessageBox::Ok);
+        }
+        ui->recordAction->setChecked(false);
+        return;
+    }
+    ui->statusbar->showMessage(tr("正在录制操作到 ") + fileName, 3000);
+}
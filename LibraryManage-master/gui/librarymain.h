@@ -2,9 +2,14 @@
 #define LIBRARYMAIN_H
 
 #include "librarydata.h"
+#include "circtrace.h"
+#include "recordmodel.h"
 #include <QMainWindow>
 #include <QCloseEvent>
-#include <QStandardItemModel>
+#include <QFutureWatcher>
+#include <QLabel>
+#include <QTimer>
+#include <memory>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -55,10 +60,38 @@ private slots:
 
     void on_aboutAction_triggered();
 
+    void on_diagnosticsAction_triggered();
+
+    void on_recordAction_triggered(bool);
+
+    void onSaveFinished();
+
+    void updateSaveProgress();
+
+    void autosave();
+
+    void on_pageUpButton_clicked();
+
+    void on_pageDnButton_clicked();
+
+    void updatePageStatus();
+
 private:
     Ui::LibraryMain *ui;
-    QStandardItemModel* userModel;
-    QStandardItemModel* bookModel;
+    UserTableModel* userModel;
+    BookTableModel* bookModel;
+    QLabel* pageLabel;					// 状态栏中本页的位置
+    std::unique_ptr<SaveJob> saveJob;	// 正在后台写入的保存
+    QFutureWatcher<int> saveWatcher;
+    QTimer saveProgressTimer;			// 定时刷新状态栏中的保存进度
+    QTimer autosaveTimer;				// 定时保存，期间的多次修改合并为一次
+    QTimer searchTimer;					// 输入停顿后才查找，连续输入只查找一次
+    bool saveAgain = false;				// 保存进行中又请求了保存，完成后再保存一次
+    circtrace::Recorder recorder;		// 录制借还、查找与增删改，供 librarycli 回放
+
+    void saveData();
+
+    void waitForSave();
 
     void initBookTable();
 
@@ -68,13 +101,9 @@ private:
 
     void displayUserData();
 
-    void displayBookList(List<Node<BookInfo>*>);
-
-    void displayUserList(List<Node<UserInfo>*>);
-
-    void appendSingleBook(Node<BookInfo>*);
+    void displayBookSearch(const std::string &);
 
-    void appendSingleUser(Node<UserInfo>*);
+    void displayUserSearch(const std::string &);
 
     void displaySingleBook(Node<BookInfo>*);
 
@@ -49,7 +49,8 @@ void LoginDialog::on_buttonBox_accepted()
     password = ui->pwdEdit->text().toStdString();
 
     // 调用库函数进行登录验证
-    if (lib.login(username, password)) {
+    auto user = lib.login(username, password);
+    if (user) {
         // 如果登录成功，根据复选框状态保存登录信息到文件
         if (ui->checkBox->isChecked()) {
             std::ofstream output("saved");
@@ -57,7 +58,7 @@ void LoginDialog::on_buttonBox_accepted()
         }
 
         // 设置全局变量记录登录用户ID并接受对话框
-        loginUserID = lib.findUser(username)->elem.identifier;
+        loginUserID = user->elem.identifier;
         accept();
     } else {
         // 如果登录失败，弹出警告对话框
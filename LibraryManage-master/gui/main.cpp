@@ -3,6 +3,9 @@
 #include <QApplication>
 #include <QLocale>
 #include <QTranslator>
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#endif
 
 // 全局变量声明
 Library lib;
@@ -27,6 +30,14 @@ int main(int argc, char *argv[])
         }
     }
 
+    // csv 文件的分隔符与系统的列表分隔符一致，便于用 Excel 直接打开
+#ifdef Q_OS_WIN
+    wchar_t separator[4];
+    if (GetLocaleInfoW(LOCALE_USER_DEFAULT, LOCALE_SLIST, separator, 4) > 1 && separator[0] < 0x80) {
+        lib.DIVIDE_CHAR = (char)separator[0];
+    }
+#endif
+
     // 读取图书数据
     if (lib.read("user.csv", "book.csv")) {
         loginUserID = -1; // 初始用户ID设为-1，表示未登录
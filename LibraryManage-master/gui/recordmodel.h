@@ -0,0 +1,566 @@
+#ifndef RECORDMODEL_H
+#define RECORDMODEL_H
+
+#include "librarydata.h"
+#include "hashindex.h"
+#include "searchjob.h"
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// 表格模型的公共基类：模板类无法声明信号
+class RecordModelBase : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    explicit RecordModelBase(QObject *parent = nullptr): QAbstractTableModel(parent) {}
+
+signals:
+    // 当前页的位置、能否翻页或结果总数可能发生了变化
+    void pageChanged();
+};
+
+// 图书或用户表格的数据模型，供主窗口与各对话框的表格共用
+// 只保存各行对应的节点指针，单元格内容在视图绘制时由 data() 从节点读取，不可见的行不做任何转换
+// Library 的变更通知被转换为单行的 dataChanged / rowsInserted / rowsRemoved，视图的滚动位置与选中行得以保留
+// 全部记录与查找结果按页显示：以本页首尾节点为游标向前后各取一页，翻页只访问一页的记录，结果集从不完整生成；
+// 开启后台查找时每一页都在工作线程中分批取得，结果陆续加入表格，新的查找或翻页会取消尚未完成的查找
+template<class T> class RecordTableModel : public RecordModelBase, public LibraryListener {
+public:
+    // 借阅关系另一侧的记录类型
+    typedef typename std::conditional<std::is_same<T, BookInfo>::value, UserInfo, BookInfo>::type Peer;
+
+    explicit RecordTableModel(Library &library, QObject *parent = nullptr):
+        RecordModelBase(parent), library(library), headers(defaultHeaders()) {
+        library.addListener(this);
+    }
+
+    ~RecordTableModel() {
+        library.removeListener(this);
+        cancelSearch();
+        searchPool.waitForDone();
+    }
+
+    static constexpr int PAGE_SIZE = 100;	// 每页行数
+
+    // 开启后，分页显示的查找与翻页在工作线程中进行，不阻塞界面线程
+    void setBackgroundSearch(bool enabled) {
+        background = enabled;
+        searchPool.setMaxThreadCount(1);
+    }
+    // 显示给定的一组记录（如按编号查找的结果），之后新增的记录不会加入
+    void setRows(std::vector<Node<T>*> nodes) {
+        cancelSearch();
+        scope = FIXED;
+        owner = nullptr;
+        resetRows(std::move(nodes));
+        emit pageChanged();
+    }
+
+    void setRows(const List<T> &list) {
+        std::vector<Node<T>*> nodes;
+        nodes.reserve(list.size());
+        for (auto *p = list.begin(); p != list.end(); p = p->next) nodes.push_back(p);
+        setRows(std::move(nodes));
+    }
+
+    void setRows(const List<Node<T>*> &list) {
+        std::vector<Node<T>*> nodes;
+        nodes.reserve(list.size());
+        for (auto *p = list.begin(); p != list.end(); p = p->next) {
+            if (p->elem) nodes.push_back(p->elem);
+        }
+        setRows(std::move(nodes));
+    }
+    // 分页显示库中全部记录，从第一页开始
+    void showAll() {
+        showSearch(std::string());
+    }
+    // 分页显示名称包含 name 的记录，从第一页开始；之后新增的匹配记录落在最后一页时随之加入
+    void showSearch(const std::string &name) {
+        cancelSearch();
+        scope = PAGED;
+        owner = nullptr;
+        query = name;
+        if (background) {
+            requestPage(nullptr, true, 0);
+        } else {
+            loadPage(nullptr, true);
+        }
+    }
+    // 翻到下一页，已是最后一页时返回 false
+    bool nextPage() {
+        if (scope != PAGED || !morePages || rows.empty()) return false;
+        int start = pageStart + (int)rows.size();
+        if (background) {
+            requestPage(rows.back(), true, start);
+            return true;
+        }
+        loadPage(rows.back(), true);
+        pageStart = start;
+        emit pageChanged();
+        return true;
+    }
+    // 翻到上一页，已是第一页时返回 false
+    bool prevPage() {
+        if (scope != PAGED || !earlierPages || rows.empty()) return false;
+        int start = std::max(0, pageStart - PAGE_SIZE);
+        if (background) {
+            requestPage(rows.front(), false, start);
+            return true;
+        }
+        if (loadPage(rows.front(), false)) pageStart = start;
+        emit pageChanged();
+        return true;
+    }
+    // 后台查找是否仍在进行
+    bool isSearching() const {
+        return searching;
+    }
+
+    bool hasNextPage() const {
+        return scope == PAGED && morePages;
+    }
+
+    bool hasPrevPage() const {
+        return scope == PAGED && earlierPages;
+    }
+    // 本页第一行在全部结果中的序号（从 0 开始）
+    int pageFirst() const {
+        return pageStart;
+    }
+    // 结果总数；查找结果的总数需要完整查找才能得到，此时返回 -1
+    int total() const {
+        if (scope != PAGED) return (int)rows.size();
+        return query.empty() ? records().size() : -1;
+    }
+    // 显示与 peer 有借阅关系的记录（同一记录只显示一行），随借还增减
+    void showLoans(Node<Peer> *peer) {
+        std::vector<Node<T>*> nodes;
+        if (peer) {
+            const auto &loans = loansOf(peer);
+            HashIndex<Node<T>*, int> seen;
+            nodes.reserve(loans.size());
+            for (auto *p = loans.begin(); p != loans.end(); p = p->next) {
+                Node<T> *node = partnerOf(p);
+                if (node && seen.insert(node, 0)) nodes.push_back(node);
+            }
+        }
+        setRows(std::move(nodes));
+        scope = LOANS;
+        owner = peer;
+    }
+
+    void clear() {
+        setRows(std::vector<Node<T>*>());
+    }
+    // 取某行的节点，行号无效时返回空指针
+    Node<T>* node(int row) const {
+        if (row < 0 || row >= (int)rows.size()) return nullptr;
+        return rows[row];
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : (int)rows.size();
+    }
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : headers.size();
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+        if (!index.isValid() || role != Qt::DisplayRole) return QVariant();
+        Node<T> *p = node(index.row());
+        if (!p) return QVariant();
+        return field(p->elem, index.column());
+    }
+
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override {
+        if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 && section < headers.size()) {
+            return headers[section];
+        }
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    bool setHeaderData(int section, Qt::Orientation orientation, const QVariant &value,
+                       int role = Qt::EditRole) override {
+        if (orientation != Qt::Horizontal || section < 0 || section >= headers.size()) return false;
+        if (role != Qt::EditRole && role != Qt::DisplayRole) return false;
+        headers[section] = value.toString();
+        emit headerDataChanged(orientation, section, section);
+        return true;
+    }
+
+    void bookAdded(Node<BookInfo> *book) override {
+        recordAdded(book);
+    }
+
+    void userAdded(Node<UserInfo> *user) override {
+        recordAdded(user);
+    }
+
+    void bookRemoved(Node<BookInfo> *book) override {
+        recordRemoved(book);
+    }
+
+    void userRemoved(Node<UserInfo> *user) override {
+        recordRemoved(user);
+    }
+
+    void bookChanged(int, Node<BookInfo> *book) override {
+        recordChanged(book);
+    }
+
+    void userChanged(int, Node<UserInfo> *user) override {
+        recordChanged(user);
+    }
+
+    void loanAdded(Node<UserInfo> *user, Node<BookInfo> *book) override {
+        loanChanged(user, book, true);
+    }
+
+    void loanRemoved(Node<UserInfo> *user, Node<BookInfo> *book) override {
+        loanChanged(user, book, false);
+    }
+
+    void reloaded() override {
+        if (scope == PAGED) showSearch(query);
+    }
+
+private:
+    enum Scope {
+        FIXED,	// 固定的一组记录
+        PAGED,	// 名称包含 query 的记录（query 为空即全部记录），按页显示
+        LOANS	// 与 owner 有借阅关系的记录
+    };
+
+    Library &library;
+    std::vector<Node<T>*> rows;		// 各行对应的节点
+    QStringList headers;			// 列标题
+    Scope scope = FIXED;
+    Node<Peer> *owner = nullptr;	// scope 为 LOANS 时借阅关系的另一方
+    HashIndex<Node<T>*, int> rowOf;	// 节点 -> 行号，收到第一条通知时才建立
+    bool indexed = false;
+    std::string query;				// scope 为 PAGED 时的查找内容
+    int pageStart = 0;				// 本页第一行的序号；删除页前的记录后可能偏大，回到第一页时校正
+    bool morePages = false;			// 本页之后还有结果
+    bool earlierPages = false;		// 本页之前还有结果
+    bool background = false;		// 见 setBackgroundSearch()
+    bool searching = false;
+    bool searchForward = true;		// 进行中的查找的方向
+    int searchID = 0;				// 当前查找的编号，已取消的查找送回的结果据此丢弃
+    uint64_t searchRemovals = 0;	// 开始查找时 Library 已删除的记录数
+    std::vector<Node<T>*> lateAdded;	// 查找期间新增的匹配记录，查找可能已越过链表末尾而没有取得
+    std::shared_ptr<SearchJob<T>> searchJob;
+    profiler::Clock::time_point searchStart;	// 进行中的查找开始的时刻，用于统计后台取一页的总耗时
+    QThreadPool searchPool;			// 同一时间只运行一个查找，析构时等待其结束
+
+    void resetRows(std::vector<Node<T>*> nodes) {
+        beginResetModel();
+        rows = std::move(nodes);
+        rowOf.clear();
+        indexed = false;
+        endResetModel();
+    }
+    // 取 from 之后（或之前）至多 limit 条匹配的记录，按链表顺序追加到 out，返回值同 Library::fuzzyFindBook
+    Node<T>* fetch(Node<T> *from, bool forward, size_t limit, std::vector<Node<T>*> &out,
+                   size_t budget = SIZE_MAX) {
+        if constexpr (std::is_same<T, BookInfo>::value) {
+            return library.fuzzyFindBook(query, from, forward, limit, out, budget);
+        } else {
+            return library.fuzzyFindUser(query, from, forward, limit, out, budget);
+        }
+    }
+
+    void cancelSearch() {
+        if (searchJob) searchJob->cancel();
+        searchJob.reset();
+        searching = false;
+        searchID++;
+        lateAdded.clear();
+    }
+    // 在工作线程中取 from 相邻的一页，先清空表格，结果由 receive 陆续加入
+    void requestPage(Node<T> *from, bool forward, int start) {
+        cancelSearch();
+        resetRows(std::vector<Node<T>*>());
+        pageStart = start;
+        searchForward = forward;
+        morePages = !forward;
+        earlierPages = forward && from;
+        searching = true;
+        searchStart = profiler::Clock::now();
+        searchRemovals = library.removals();
+        int id = searchID;
+        searchJob = std::make_shared<SearchJob<T>>(library, query, from, forward, PAGE_SIZE + 1,
+                [this, id](std::vector<Node<T>*> &batch, bool done, bool stale) {
+            QMetaObject::invokeMethod(this, [this, id, batch = std::move(batch), done, stale]() mutable {
+                receive(id, batch, done, stale);
+            }, Qt::QueuedConnection);
+        });
+        std::shared_ptr<SearchJob<T>> job = searchJob;
+        QtConcurrent::run(&searchPool, [job]() { job->run(); });
+        emit pageChanged();
+    }
+    // 在界面线程中接收一批结果；多取的一条只用于判断能否继续翻页
+    void receive(int id, std::vector<Node<T>*> &batch, bool done, bool stale) {
+        if (id != searchID) return;
+        if (stale || library.removals() != searchRemovals) {
+            // 查找期间删除了记录，游标或尚未送达的结果可能已失效，回到第一页重新查找
+            requestPage(nullptr, true, 0);
+            return;
+        }
+        size_t room = PAGE_SIZE - rows.size();
+        if (searchForward) {
+            if (batch.size() > room) {
+                batch.resize(room);
+                morePages = true;
+            }
+            insertRows((int)rows.size(), batch);
+        } else {
+            // 向前翻页时各批由近及远到达，依次插到表头
+            if (batch.size() > room) {
+                batch.erase(batch.begin(), batch.end() - room);
+                earlierPages = true;
+            }
+            insertRows(0, batch);
+        }
+        if (done) {
+            searching = false;
+            searchJob.reset();
+            profiler::finish(searchMetric(), searchStart);
+            if (!searchForward && (int)rows.size() < PAGE_SIZE) {
+                requestPage(nullptr, true, 0);
+                return;
+            }
+            // 向后翻页时补上查找未取得的新记录；向前翻页的结果都在游标之前，与新记录无关
+            std::vector<Node<T>*> added;
+            added.swap(lateAdded);
+            if (searchForward) {
+                for (Node<T> *node : added) {
+                    if (rowFor(node) < 0) recordAdded(node);
+                }
+            }
+        }
+        emit pageChanged();
+    }
+
+    void insertRows(int row, const std::vector<Node<T>*> &nodes) {
+        if (nodes.empty()) return;
+        beginInsertRows(QModelIndex(), row, row + (int)nodes.size() - 1);
+        rows.insert(rows.begin() + row, nodes.begin(), nodes.end());
+        indexed = false;
+        endInsertRows();
+    }
+    // 以 from 为游标载入相邻的一页，多取一条以判断是否还能继续翻页；skip 为正在删除、尚在链表中的节点
+    // 向前不足一页时（期间删除了记录）改为载入第一页，返回 false
+    bool loadPage(Node<T> *from, bool forward, Node<T> *skip = nullptr) {
+        profiler::ScopedTimer timer(loadPageMetric());
+        std::vector<Node<T>*> nodes;
+        fetch(from, forward, PAGE_SIZE + (skip ? 2 : 1), nodes);
+        if (skip) {
+            size_t count = nodes.size();
+            nodes.erase(std::remove(nodes.begin(), nodes.end(), skip), nodes.end());
+            if (nodes.size() == count && count > PAGE_SIZE + 1) nodes.pop_back();
+        }
+        if (forward) {
+            morePages = (int)nodes.size() > PAGE_SIZE;
+            if (morePages) nodes.pop_back();
+            earlierPages = from != nullptr;
+            if (!from) pageStart = 0;
+        } else if ((int)nodes.size() > PAGE_SIZE) {
+            nodes.erase(nodes.begin());
+            earlierPages = morePages = true;
+        } else {
+            loadPage(nullptr, true);
+            return false;
+        }
+        resetRows(std::move(nodes));
+        if (!from) emit pageChanged();
+        return true;
+    }
+    // 在界面线程中载入一页的耗时，首次使用时登记
+    static profiler::Metric &loadPageMetric() {
+        static profiler::Metric metric(std::is_same<T, BookInfo>::value ?
+                                       "BookTableModel/loadPage" : "UserTableModel/loadPage");
+        return metric;
+    }
+    // 后台查找从开始到取齐一页的耗时，含等待界面线程接收各批结果的时间
+    static profiler::Metric &searchMetric() {
+        static profiler::Metric metric(std::is_same<T, BookInfo>::value ?
+                                       "BookTableModel/backgroundSearch" : "UserTableModel/backgroundSearch");
+        return metric;
+    }
+    // 名称是否与查找内容匹配
+    bool matches(Node<T> *node) const {
+        return node->elem.name.find(query) != std::string::npos;
+    }
+
+    const List<T> &records() const {
+        if constexpr (std::is_same<T, BookInfo>::value) return library.books;
+        else return library.users;
+    }
+
+    static const auto &loansOf(Node<Peer> *peer) {
+        if constexpr (std::is_same<T, BookInfo>::value) return peer->elem.books;
+        else return peer->elem.readers;
+    }
+
+    template<class Loan>
+    static Node<T>* partnerOf(Node<Loan> *loan) {
+        if constexpr (std::is_same<T, BookInfo>::value) return loan->elem.book;
+        else return loan->elem.user;
+    }
+    // 节点所在行，不在表中时返回 -1
+    int rowFor(Node<T> *target) {
+        if (!indexed) {
+            rowOf.clear();
+            rowOf.reserve(rows.size());
+            for (int row = 0; row < (int)rows.size(); row++) rowOf.insert(rows[row], row);
+            indexed = true;
+        }
+        const int *row = rowOf.get(target);
+        return row ? *row : -1;
+    }
+
+    void appendRow(Node<T> *target) {
+        if (rowFor(target) >= 0) return;
+        int row = (int)rows.size();
+        beginInsertRows(QModelIndex(), row, row);
+        rows.push_back(target);
+        rowOf.insert(target, row);
+        endInsertRows();
+    }
+    // 移除一行，其后各行的行号前移
+    void removeRow(Node<T> *target) {
+        int row = rowFor(target);
+        if (row < 0) return;
+        beginRemoveRows(QModelIndex(), row, row);
+        rows.erase(rows.begin() + row);
+        rowOf.erase(target);
+        for (int i = row; i < (int)rows.size(); i++) *rowOf.get(rows[i]) = i;
+        endRemoveRows();
+    }
+
+    // 新记录总在链表末尾，只有最后一页需要处理
+    template<class N>
+    void recordAdded(Node<N> *added) {
+        if constexpr (std::is_same<N, T>::value) {
+            if (scope != PAGED || !matches(added)) return;
+            if (searching) {
+                lateAdded.push_back(added);
+                return;
+            }
+            if (!morePages && (int)rows.size() < PAGE_SIZE) {
+                appendRow(added);
+            } else {
+                morePages = true;
+            }
+            emit pageChanged();
+        }
+    }
+    // 分页时从下一页补上一行，使本页保持满页
+    template<class N>
+    void recordRemoved(Node<N> *removed) {
+        if constexpr (std::is_same<N, T>::value) {
+            if (searching) lateAdded.erase(std::remove(lateAdded.begin(), lateAdded.end(), removed), lateAdded.end());
+            if (rowFor(removed) < 0) {
+                if (scope == PAGED) emit pageChanged();
+                return;
+            }
+            removeRow(removed);
+            if (scope != PAGED || searching) return;
+            if (rows.empty()) {
+                // 本页最后一条也被删除，该节点已不能作为游标
+                if (background) {
+                    requestPage(nullptr, true, 0);
+                } else {
+                    loadPage(nullptr, true, removed);
+                }
+                return;
+            }
+            if (morePages) {
+                // 被删除的节点此时仍在链表中，取结果时需跳过；限定检查的候选数，找不到时保留下一页
+                std::vector<Node<T>*> next;
+                Node<T> *resume = fetch(rows.back(), true, 3, next, SearchJob<T>::BATCH_BUDGET);
+                next.erase(std::remove(next.begin(), next.end(), removed), next.end());
+                if (!next.empty()) appendRow(next.front());
+                morePages = next.size() > 1 || resume;
+            }
+            emit pageChanged();
+        } else {
+            if (scope == LOANS && owner == removed) clear();
+        }
+    }
+
+    template<class N>
+    void recordChanged(Node<N> *changed) {
+        if constexpr (std::is_same<N, T>::value) {
+            int row = rowFor(changed);
+            if (row >= 0) emit dataChanged(index(row, 0), index(row, headers.size() - 1));
+        }
+    }
+    // 借阅数量列随借还变化；显示借阅关系时还要增减行
+    void loanChanged(Node<UserInfo> *user, Node<BookInfo> *book, bool added) {
+        Node<T> *self;
+        Node<Peer> *peer;
+        if constexpr (std::is_same<T, BookInfo>::value) {
+            self = book;
+            peer = user;
+        } else {
+            self = user;
+            peer = book;
+        }
+        if (scope == LOANS && owner == peer) {
+            if (added) {
+                appendRow(self);
+            } else if (!library.hasBorrowed(user, book)) {
+                removeRow(self);
+                return;
+            }
+        }
+        recordChanged(self);
+    }
+
+    static QStringList defaultHeaders();
+
+    static QVariant field(const T &elem, int column);
+};
+
+template<> inline QStringList RecordTableModel<BookInfo>::defaultHeaders() {
+    return QStringList() << QObject::tr("名称") << QObject::tr("编号")
+                         << QObject::tr("总数量") << QObject::tr("剩余数量");
+}
+
+template<> inline QStringList RecordTableModel<UserInfo>::defaultHeaders() {
+    return QStringList() << QObject::tr("用户名") << QObject::tr("编号") << QObject::tr("已借阅数量");
+}
+
+template<> inline QVariant RecordTableModel<BookInfo>::field(const BookInfo &book, int column) {
+    switch (column) {
+    case 0: return QString::fromStdString(book.name);
+    case 1: return book.identifier;
+    case 2: return book.quantity;
+    case 3: return book.quantity - book.readers.size();
+    }
+    return QVariant();
+}
+
+template<> inline QVariant RecordTableModel<UserInfo>::field(const UserInfo &user, int column) {
+    switch (column) {
+    case 0: return QString::fromStdString(user.name);
+    case 1: return user.identifier;
+    case 2: return user.books.size();
+    }
+    return QVariant();
+}
+
+typedef RecordTableModel<BookInfo> BookTableModel;
+typedef RecordTableModel<UserInfo> UserTableModel;
+
+#endif // RECORDMODEL_H
@@ -4,6 +4,13 @@
 #include "bookinfodialog.h"
 #include "userinfodialog.h"
 
+namespace {
+
+profiler::Metric bookDataMetric("SelectDialog::displayBookData");
+profiler::Metric userDataMetric("SelectDialog::displayUserData");
+
+}
+
 SelectDialog::SelectDialog(QWidget *parent, int _bookID, int _userID) :
     QDialog(parent),
     ui(new Ui::SelectDialog)
@@ -14,8 +21,8 @@ SelectDialog::SelectDialog(QWidget *parent, int _bookID, int _userID) :
     ui->lineEdit->setValidator(new QIntValidator(0, INT_MAX, this));
 
     // 初始化模型和视图
-    bookModel = new QStandardItemModel();
-    userModel = new QStandardItemModel();
+    bookModel = new BookTableModel(lib, this);
+    userModel = new UserTableModel(lib, this);
     ui->tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
     ui->tableView->setSelectionMode(QAbstractItemView::SingleSelection);
 
@@ -41,12 +48,6 @@ SelectDialog::~SelectDialog()
 void SelectDialog::initBookTable()
 {
     // 初始化图书表格视图
-    bookModel->clear();
-    bookModel->setColumnCount(4);
-    bookModel->setHeaderData(0, Qt::Horizontal, tr("名称"));
-    bookModel->setHeaderData(1, Qt::Horizontal, tr("编号"));
-    bookModel->setHeaderData(2, Qt::Horizontal, tr("总数量"));
-    bookModel->setHeaderData(3, Qt::Horizontal, tr("剩余数量"));
     ui->tableView->setModel(bookModel);
     ui->tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     ui->tableView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Fixed);
@@ -62,11 +63,6 @@ void SelectDialog::initBookTable()
 void SelectDialog::initUserTable()
 {
     // 初始化用户表格视图
-    userModel->clear();
-    userModel->setColumnCount(3);
-    userModel->setHeaderData(0, Qt::Horizontal, tr("用户名"));
-    userModel->setHeaderData(1, Qt::Horizontal, tr("编号"));
-    userModel->setHeaderData(2, Qt::Horizontal, tr("已借阅数量"));
     ui->tableView->setModel(userModel);
     ui->tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     ui->tableView->horizontalHeader()->setSectionResizeMode(2, QHeaderView::Fixed);
@@ -78,42 +74,18 @@ void SelectDialog::initUserTable()
 void SelectDialog::displayBookData()
 {
     // 显示图书数据
+    profiler::ScopedTimer timer(bookDataMetric);
     initBookTable();
-    for (auto p = lib.books.begin(); p != lib.books.end(); p = p->next) {
-        appendSingleBook(p);
-    }
+    // 选择对话框没有翻页按钮，一次列出全部图书
+    bookModel->setRows(lib.books);
 }
 
 void SelectDialog::displayUserData()
 {
     // 显示用户数据
+    profiler::ScopedTimer timer(userDataMetric);
     initUserTable();
-    for (auto p = lib.users.begin(); p != lib.users.end(); p = p->next) {
-        appendSingleUser(p);
-    }
-}
-
-void SelectDialog::appendSingleBook(Node<BookInfo>* p)
-{
-    // 添加单本图书到表格
-    if (!p) return;
-    QList<QStandardItem*> list;
-    list << new QStandardItem(p->elem.name.data())
-         << new QStandardItem(QString::number(p->elem.identifier))
-         << new QStandardItem(QString::number(p->elem.quantity))
-         << new QStandardItem(QString::number(p->elem.quantity - p->elem.readers.size()));
-    bookModel->appendRow(list);
-}
-
-void SelectDialog::appendSingleUser(Node<UserInfo>* p)
-{
-    // 添加单个用户到表格
-    if (!p) return;
-    QList<QStandardItem*> list;
-    list << new QStandardItem(p->elem.name.data())
-         << new QStandardItem(QString::number(p->elem.identifier))
-         << new QStandardItem(QString::number(p->elem.books.size()));
-    userModel->appendRow(list);
+    userModel->setRows(lib.users);
 }
 
 int SelectDialog::getSelection()
@@ -2,8 +2,8 @@
 #define SELECTDIALOG_H
 
 #include "librarydata.h"
+#include "recordmodel.h"
 #include <QDialog>
-#include <QStandardItemModel>
 
 namespace Ui {
 class SelectDialog;
@@ -29,8 +29,8 @@ private slots:
 
 private:
     Ui::SelectDialog *ui;
-    QStandardItemModel* userModel;
-    QStandardItemModel* bookModel;
+    UserTableModel* userModel;
+    BookTableModel* bookModel;
 
     void initBookTable();
 
@@ -40,10 +40,6 @@ private:
 
     void displayUserData();
 
-    void appendSingleBook(Node<BookInfo>*);
-
-    void appendSingleUser(Node<UserInfo>*);
-
     int getSelection();
 
     int getSelection(const QModelIndex&);
@@ -7,12 +7,18 @@
 #include <QMessageBox>
 #include <QIntValidator>
 
+namespace {
+
+profiler::Metric tableMetric("UserInfoDialog::displayTable");
+
+}
+
 UserInfoDialog::UserInfoDialog(QWidget *parent, int _userID) :
     QDialog(parent),
     ui(new Ui::UserInfoDialog) {
     ui->setupUi(this);
 
-    bookModel = new QStandardItemModel();
+    bookModel = new BookTableModel(lib, this);
 
     // 设置ID输入框的验证器，只能输入非负整数
     ui->idEdit->setValidator(new QIntValidator(0, INT_MAX, this));
@@ -62,26 +68,15 @@ void UserInfoDialog::receiveBookData(QString data) {
         QMessageBox::information(this, tr("提示"), tr("这本书已经没有剩余了。"), QMessageBox::Ok);
         return;
     }
-    displayTable();
+    updateSummary();
 }
 
 void UserInfoDialog::receivePwdData(QString data) {
-    if (user) {
-        user->elem.password = data.toStdString();
-    } else {
-        updateUserInfo();
-        user->elem.password = data.toStdString();
-    }
+    if (!user) updateUserInfo();
+    lib.setPassword(user, data.toStdString());
 }
 
 void UserInfoDialog::initBookTable() {
-    ui->returnButton->setDisabled(true);
-    bookModel->clear();
-    bookModel->setColumnCount(4);
-    bookModel->setHeaderData(0, Qt::Horizontal, tr("名称"));
-    bookModel->setHeaderData(1, Qt::Horizontal, tr("编号"));
-    bookModel->setHeaderData(2, Qt::Horizontal, tr("总数量"));
-    bookModel->setHeaderData(3, Qt::Horizontal, tr("剩余数量"));
     ui->tableView->setModel(bookModel);
 
     // 设置表格列宽和布局
@@ -97,22 +92,16 @@ void UserInfoDialog::initBookTable() {
 }
 
 void UserInfoDialog::displayTable() {
+    profiler::ScopedTimer timer(tableMetric);
     initBookTable();
-    ui->numLabel->setText(tr("已借阅 ") + QString::number(user->elem.books.size()) + tr(" 本"));
-    for (auto p = user->elem.books.begin(); p != user->elem.books.end(); p = p->next) {
-        appendSingleBook(p->elem);
-    }
+    bookModel->showLoans(user);
+    updateSummary();
 }
 
-// 添加单本书籍到表格中
-void UserInfoDialog::appendSingleBook(Node<BookInfo>* p) {
-    if (!p) return;
-    QList<QStandardItem*> list;
-    list << new QStandardItem(QString::fromStdString(p->elem.name))
-         << new QStandardItem(QString::number(p->elem.identifier))
-         << new QStandardItem(QString::number(p->elem.quantity))
-         << new QStandardItem(QString::number(p->elem.quantity - p->elem.readers.size()));
-    bookModel->appendRow(list);
+// 借还之后表格已随通知更新，只需刷新借阅数量与按钮
+void UserInfoDialog::updateSummary() {
+    ui->returnButton->setDisabled(true);
+    ui->numLabel->setText(tr("已借阅 ") + QString::number(user->elem.books.size()) + tr(" 本"));
 }
 
 // 处理归还按钮点击事件
@@ -120,7 +109,7 @@ void UserInfoDialog::on_returnButton_clicked() {
     if (!user) return;
     int bookID = getSelection();
     lib.returnBook(user->elem.identifier, bookID);
-    displayTable();
+    updateSummary();
 }
 
 // 获取当前选中的书籍ID
@@ -147,9 +136,9 @@ void UserInfoDialog::updateUserInfo() {
     int id = ui->idEdit->text().toInt();
     bool type = ui->adminBox->isChecked();
     if (user) {
-        user->elem.name = name.toStdString();
-        user->elem.identifier = id;
-        user->elem.type = type;
+        lib.modifyName(user, name.toStdString());
+        lib.modifyID(user, id);
+        lib.setType(user, type);
     } else {
         user = lib.add(UserInfo(name.toStdString(), id, type));
     }
@@ -221,5 +210,5 @@ void UserInfoDialog::on_tableView_doubleClicked(const QModelIndex &index) {
     int bookID = getSelection(index);
     BookInfoDialog bookDialog(this, bookID);
     bookDialog.exec();
-    displayTable();
+    updateSummary();
 }
@@ -2,9 +2,9 @@
 #define USERINFODIALOG_H
 
 #include "librarydata.h"
+#include "recordmodel.h"
 
 #include <QDialog>
-#include <QStandardItemModel>
 
 namespace Ui {
 class UserInfoDialog;
@@ -39,16 +39,16 @@ private slots:
 
 private:
     Ui::UserInfoDialog *ui;
-    QStandardItemModel* bookModel;
+    BookTableModel* bookModel;
     Node<UserInfo>* user;
 
     void initBookTable();
 
     void displayTable();
 
-    void displayBookList(List<Node<BookInfo>*>);
+    void updateSummary();
 
-    void appendSingleBook(Node<BookInfo>*);
+    void displayBookList(const List<Node<BookInfo>*> &);
 
     int getSelection();
 
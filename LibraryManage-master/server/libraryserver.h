@@ -0,0 +1,391 @@
+#ifndef LIBRARYSERVER_H
+#define LIBRARYSERVER_H
+
+// winsock2.h 须在 Windows.h 之前包含
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "librarydata.h"
+#include "protocol.h"
+#include "searchjob.h"
+
+// 借还服务：在本机 TCP 端口上以 protocol.h 中的二进制协议提供 Library 的查询与修改，
+// 多个终端共用一份内存中的数据。每个连接一个线程，一次收到的多个请求依次处理后合并发送响应；
+// 各请求通过 Library 的读写锁并行执行，查询互不阻塞
+class LibraryServer {
+public:
+    explicit LibraryServer(Library &library):
+        library(library), listener(INVALID), listenPort(0), running(false) {
+#ifdef _WIN32
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+    }
+
+    ~LibraryServer() {
+        stop();
+        if (listener != INVALID) closeSocket(listener);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+
+    LibraryServer(const LibraryServer &) = delete;
+    LibraryServer &operator =(const LibraryServer &) = delete;
+
+    // 在 127.0.0.1 的 port 端口监听，port 为 0 时由系统选择；成功返回 0
+    int listen(int port) {
+        listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listener == INVALID) {
+            cerr << "无法创建套接字。" << endl;
+            return 1;
+        }
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons((unsigned short)port);
+        socklen_t size = sizeof(address);
+        if (bind(listener, (sockaddr *)&address, sizeof(address)) || ::listen(listener, SOMAXCONN)
+                || getsockname(listener, (sockaddr *)&address, &size)) {
+            cerr << "无法监听端口 " << port << "。请检查端口是否被占用。" << endl;
+            closeSocket(listener);
+            listener = INVALID;
+            return 1;
+        }
+        listenPort = ntohs(address.sin_port);
+        running = true;
+        return 0;
+    }
+    // 实际监听的端口
+    int port() const {
+        return listenPort;
+    }
+    // 接受连接，直到 stop() 被调用；已有 MAX_CLIENTS 个连接时等待其中之一断开，新连接暂留在系统的等待队列中
+    void run() {
+        bool failing = false;
+        while (running) {
+            {
+                std::unique_lock<std::mutex> lock(clientMutex);
+                clientsDone.wait(lock, [this]() { return !running || clients.size() < MAX_CLIENTS; });
+                if (!running) break;
+            }
+            Socket client = accept(listener, nullptr, nullptr);
+            if (client == INVALID) {
+                if (!running || interrupted()) continue;
+                // 文件描述符耗尽等错误会让 accept 立即再次失败，稍等再试，避免空转占满 CPU
+                if (!failing) cerr << "[警告] 接受连接失败，稍后重试。" << endl;
+                failing = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(ACCEPT_RETRY_MS));
+                continue;
+            }
+            failing = false;
+            int noDelay = 1;
+            setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char *)&noDelay, sizeof(noDelay));
+            std::lock_guard<std::mutex> lock(clientMutex);
+            if (!running) {
+                closeSocket(client);
+                break;
+            }
+            clients.push_back(client);
+            std::thread(&LibraryServer::serve, this, client).detach();
+        }
+    }
+    // 停止接受连接并断开所有客户端，等待各连接的线程结束；可在任意线程调用
+    void stop() {
+        std::unique_lock<std::mutex> lock(clientMutex);
+        if (running) {
+            running = false;
+            clientsDone.notify_all();	// 唤醒等待空位的 run
+#ifdef _WIN32
+            closesocket(listener);	// 关闭后 accept 立即返回
+            listener = INVALID;
+#else
+            shutdown(listener, SHUT_RDWR);
+#endif
+        }
+        for (Socket client : clients) shutdown(client, SHUT_BOTH);
+        clientsDone.wait(lock, [this]() { return clients.empty(); });
+    }
+    // 保存改动，与客户端的 SAVE 请求共用，同一时间只进行一次；成功返回 0
+    int save() {
+        std::lock_guard<std::mutex> lock(saveMutex);
+        return library.hasUnsavedChanges() ? library.save() : 0;
+    }
+
+private:
+#ifdef _WIN32
+    typedef SOCKET Socket;
+    typedef int socklen_t;
+    static constexpr Socket INVALID = INVALID_SOCKET;
+    static constexpr int SHUT_BOTH = SD_BOTH;
+#else
+    typedef int Socket;
+    static constexpr Socket INVALID = -1;
+    static constexpr int SHUT_BOTH = SHUT_RDWR;
+#endif
+    static constexpr size_t MAX_CLIENTS = 256;		// 同时服务的连接数上限，每个连接占一个线程
+    static constexpr int ACCEPT_RETRY_MS = 50;		// accept 出错后重试前等待的毫秒数
+
+    // 上一次套接字调用是否被信号中断
+    static bool interrupted() {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEINTR;
+#else
+        return errno == EINTR;
+#endif
+    }
+
+    // 一个连接的状态
+    struct Session {
+        int userID = -1;	// 登录用户的编号，-1 表示未登录
+    };
+
+    Library &library;
+    Socket listener;
+    int listenPort;
+    std::atomic<bool> running;
+    std::vector<Socket> clients;		// 已连接的客户端
+    std::mutex clientMutex;				// 保护 clients
+    std::condition_variable clientsDone;
+    std::mutex saveMutex;
+
+    static void closeSocket(Socket socket) {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    static bool sendAll(Socket socket, const char *data, size_t size) {
+        while (size) {
+#ifdef _WIN32
+            int n = send(socket, data, (int)size, 0);
+#elif defined(MSG_NOSIGNAL)
+            ssize_t n = send(socket, data, size, MSG_NOSIGNAL);
+#else
+            ssize_t n = send(socket, data, size, 0);
+#endif
+            if (n <= 0) return false;
+            data += n;
+            size -= n;
+        }
+        return true;
+    }
+    // 连接的线程：读入请求，处理其中所有完整的帧，再一次发出这些响应
+    void serve(Socket client) {
+        Session session;
+        std::string input, output;
+        std::vector<char> buffer(1 << 16);
+        while (true) {
+#ifdef _WIN32
+            int n = recv(client, buffer.data(), (int)buffer.size(), 0);
+#else
+            ssize_t n = recv(client, buffer.data(), buffer.size(), 0);
+#endif
+            if (n <= 0) break;
+            input.append(buffer.data(), n);
+            size_t pos = 0;
+            long long taken;
+            const char *payload;
+            uint32_t length;
+            while ((taken = protocol::nextFrame(input.data() + pos, input.size() - pos, payload, length)) > 0) {
+                protocol::Reader request(payload, length);
+                handle(request, session, output);
+                pos += taken;
+            }
+            if (taken < 0) break;
+            input.erase(0, pos);
+            if (!output.empty() && !sendAll(client, output.data(), output.size())) break;
+            output.clear();
+        }
+        closeSocket(client);
+        std::lock_guard<std::mutex> lock(clientMutex);
+        clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+        clientsDone.notify_all();
+    }
+    // 处理一个请求，把响应追加到 output
+    void handle(protocol::Reader &request, Session &session, std::string &output) {
+        uint32_t id = 0;
+        uint8_t op = 0;
+        bool valid = request.get(id) && request.get(op);
+        protocol::Frame reply(output);
+        reply.put(id);
+        size_t statusAt = output.size();
+        reply.put((uint8_t)protocol::OK);
+        size_t resultAt = output.size();
+        protocol::Status status = valid ? execute((protocol::Op)op, request, session, reply) : protocol::BAD_REQUEST;
+        output[statusAt] = (char)status;
+        if (status != protocol::OK) output.resize(resultAt);
+    }
+
+    protocol::Status execute(protocol::Op op, protocol::Reader &request, Session &session, protocol::Frame &reply) {
+        using namespace protocol;
+        int32_t a, b, c, d;
+        string name, password;
+        if (op < LOGIN || op > SAVE) return BAD_REQUEST;
+        if (op == LOGIN) {
+            if (!request.get(name) || !request.get(password)) return BAD_REQUEST;
+            auto lock = library.readLock();
+            Node<UserInfo> *user = library.login(name, password);
+            if (!user) return REJECTED;
+            session.userID = user->elem.identifier;
+            putUser(reply, user);
+            return OK;
+        }
+        if (session.userID < 0) return NOT_LOGGED_IN;
+        switch (op) {
+        case FIND_BOOK: {
+            if (!request.get(a)) return BAD_REQUEST;
+            auto lock = library.readLock();
+            Node<BookInfo> *book = library.findBook(a);
+            if (!book) return NOT_FOUND;
+            putBook(reply, book);
+            return OK;
+        }
+        case FIND_USER: {
+            if (!request.get(a)) return BAD_REQUEST;
+            auto lock = library.readLock();
+            if (a != session.userID && !isAdmin(session)) return FORBIDDEN;
+            Node<UserInfo> *user = library.findUser(a);
+            if (!user) return NOT_FOUND;
+            putUser(reply, user);
+            return OK;
+        }
+        case FUZZY_FIND_BOOK: {
+            if (!request.get(name) || !request.get(a) || !request.get(b)) return BAD_REQUEST;
+            auto lock = library.readLock();
+            Node<BookInfo> *from = a < 0 ? nullptr : library.findBook(a);
+            if (a >= 0 && !from) return NOT_FOUND;
+            // 与界面的分批查找相同，一次至多检查 BATCH_BUDGET 个候选，读锁不会被长时间占用
+            std::vector<Node<BookInfo>*> found;
+            Node<BookInfo> *resume = library.fuzzyFindBook(name, from, true, pageSize(b), found,
+                                                           SearchJob<BookInfo>::BATCH_BUDGET);
+            reply.put((int32_t)found.size());
+            for (auto *book : found) putBook(reply, book);
+            reply.put((int32_t)(resume ? resume->elem.identifier : -1));
+            return OK;
+        }
+        case FUZZY_FIND_USER: {
+            if (!request.get(name) || !request.get(a) || !request.get(b)) return BAD_REQUEST;
+            auto lock = library.readLock();
+            if (!isAdmin(session)) return FORBIDDEN;
+            Node<UserInfo> *from = a < 0 ? nullptr : library.findUser(a);
+            if (a >= 0 && !from) return NOT_FOUND;
+            std::vector<Node<UserInfo>*> found;
+            Node<UserInfo> *resume = library.fuzzyFindUser(name, from, true, pageSize(b), found,
+                                                           SearchJob<UserInfo>::BATCH_BUDGET);
+            reply.put((int32_t)found.size());
+            for (auto *user : found) putUser(reply, user);
+            reply.put((int32_t)(resume ? resume->elem.identifier : -1));
+            return OK;
+        }
+        case BORROW:
+        case RETURN: {
+            if (!request.get(a) || !request.get(b)) return BAD_REQUEST;
+            auto lock = library.writeLock();
+            if (a != session.userID && !isAdmin(session)) return FORBIDDEN;
+            Node<UserInfo> *user = library.findUser(a);
+            Node<BookInfo> *book = library.findBook(b);
+            if (!user || !book) return NOT_FOUND;
+            // 已借完是常态，不必像界面操作那样输出提示
+            if (op == BORROW && book->elem.readers.size() >= book->elem.quantity) return REJECTED;
+            int state = op == BORROW ? library.borrowBook(user, book) : library.returnBook(user, book);
+            return state ? REJECTED : OK;
+        }
+        default:
+            break;
+        }
+        // 以下仅管理员
+        if (op == SAVE) {
+            {
+                auto lock = library.readLock();
+                if (!isAdmin(session)) return FORBIDDEN;
+            }
+            return save() ? REJECTED : OK;
+        }
+        auto lock = library.writeLock();
+        if (!isAdmin(session)) return FORBIDDEN;
+        switch (op) {
+        case ADD_BOOK:
+            if (!request.get(name) || !request.get(a) || !request.get(b)) return BAD_REQUEST;
+            if (!library.canAdd(BookInfo(name, a, b))) return REJECTED;
+            return library.add(BookInfo(name, a, b)) ? OK : REJECTED;
+        case ADD_USER:
+            if (!request.get(name) || !request.get(password) || !request.get(a) || !request.get(b)) return BAD_REQUEST;
+            if (!library.canAdd(UserInfo(name, password, a, b))) return REJECTED;
+            return library.add(UserInfo(name, password, a, b)) ? OK : REJECTED;
+        case MODIFY_BOOK: {
+            if (!request.get(a) || !request.get(name) || !request.get(b) || !request.get(c)) return BAD_REQUEST;
+            Node<BookInfo> *book = library.findBook(a);
+            if (!book) return NOT_FOUND;
+            // 与图书详情对话框相同：编号不能与其他图书重复，数量不能少于借出数
+            if (!library.canModify(book, BookInfo(name, b, c))) return REJECTED;
+            library.modify(book, BookInfo(name, b, c));
+            return OK;
+        }
+        case MODIFY_USER: {
+            if (!request.get(a) || !request.get(name) || !request.get(password)
+                    || !request.get(b) || !request.get(c)) return BAD_REQUEST;
+            Node<UserInfo> *user = library.findUser(a);
+            if (!user) return NOT_FOUND;
+            if (!library.canModify(user, UserInfo(name, password, b, c))) return REJECTED;
+            library.modify(user, UserInfo(name, password, b, c));
+            if (a == session.userID) session.userID = b;
+            return OK;
+        }
+        case DEL_BOOK:
+            if (!request.get(a) || !request.get(d)) return BAD_REQUEST;
+            if (!library.findBook(a)) return NOT_FOUND;
+            return library.del(library.findBook(a), d != 0) ? OK : REJECTED;
+        case DEL_USER:
+            if (!request.get(a) || !request.get(d)) return BAD_REQUEST;
+            if (!library.findUser(a)) return NOT_FOUND;
+            return library.del(library.findUser(a), d != 0) ? OK : REJECTED;
+        default:
+            return BAD_REQUEST;
+        }
+    }
+    // 会话的用户是否为管理员，调用者须持有锁
+    bool isAdmin(const Session &session) {
+        Node<UserInfo> *user = library.findUser(session.userID);
+        return user && library.isAdmin(user);
+    }
+
+    static size_t pageSize(int32_t requested) {
+        if (requested < 0) return 0;
+        return requested < protocol::MAX_PAGE ? requested : protocol::MAX_PAGE;
+    }
+
+    static void putBook(protocol::Frame &reply, Node<BookInfo> *book) {
+        const BookInfo &elem = book->elem;
+        reply.put(elem.name).put((int32_t)elem.identifier).put((int32_t)elem.quantity)
+                .put((int32_t)(elem.quantity - elem.readers.size()));
+    }
+
+    static void putUser(protocol::Frame &reply, Node<UserInfo> *user) {
+        const UserInfo &elem = user->elem;
+        reply.put(elem.name).put((int32_t)elem.identifier).put((int32_t)elem.type)
+                .put((int32_t)elem.books.size());
+    }
+};
+
+#endif // LIBRARYSERVER_H
@@ -0,0 +1,14 @@
+TEMPLATE = app
+TARGET = libraryserver
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+include(../core/core.pri)
+
+win32: LIBS += -lws2_32
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    libraryserver.h
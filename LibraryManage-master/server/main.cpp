@@ -0,0 +1,52 @@
+// 借还服务：读入数据文件后在本机 TCP 端口上提供 Library 的查询、借还与增删改，多个终端共用一份数据
+// 用法：libraryserver [端口] [user.csv] [book.csv]
+// 每分钟自动保存一次；收到 Ctrl+C 或终止信号时断开所有客户端并保存后退出
+#include "libraryserver.h"
+
+#include <chrono>
+#include <csignal>
+
+Library lib;
+
+namespace {
+
+std::atomic<bool> quit(false);
+
+void onSignal(int) {
+    quit = true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    int port = argc > 1 ? atoi(argv[1]) : 5150;
+    const char *userFile = argc > 2 ? argv[2] : "user.csv";
+    const char *bookFile = argc > 3 ? argv[3] : "book.csv";
+
+    // 数据文件不存在时以空数据启动，保存时创建
+    if (lib.read(userFile, bookFile)) {
+        cerr << "[警告] 以空数据启动，保存时将写入 " << userFile << " 与 " << bookFile << "。" << endl;
+    }
+    LibraryServer server(lib);
+    if (server.listen(port)) return 1;
+    cerr << "[信息] 正在 127.0.0.1:" << server.port() << " 上提供服务。" << endl;
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::thread acceptor(&LibraryServer::run, &server);
+    auto lastSave = std::chrono::steady_clock::now();
+    while (!quit) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (std::chrono::steady_clock::now() - lastSave >= std::chrono::minutes(1)) {
+            if (server.save()) cerr << "[警告] 自动保存失败。" << endl;
+            lastSave = std::chrono::steady_clock::now();
+        }
+    }
+    server.stop();
+    acceptor.join();
+    if (server.save()) {
+        cerr << "[警告] 退出前保存失败。" << endl;
+        return 1;
+    }
+    return 0;
+}